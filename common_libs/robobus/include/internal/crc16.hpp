@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+
+namespace robobus::internal {
+/// @brief CRC-16/CCITT-FALSE (多項式 0x1021，初期値 0xFFFF)
+/// @details 表引きで 1 バイトずつ計算する．Update() を続けて呼ぶことで
+///  分割されたデータの CRC を求められる
+class Crc16 {
+  static constexpr auto kTable = [] {
+    std::array<std::uint16_t, 256> table{};
+    for (std::size_t i = 0; i < 256; i++) {
+      auto crc = static_cast<std::uint16_t>(i << 8);
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x8000) != 0 ? static_cast<std::uint16_t>(crc << 1 ^ 0x1021)
+                                  : static_cast<std::uint16_t>(crc << 1);
+      }
+      table[i] = crc;
+    }
+    return table;
+  }();
+
+  std::uint16_t crc_ = 0xFFFF;
+
+ public:
+  constexpr void Update(std::uint8_t const *data, std::size_t size) {
+    for (std::size_t i = 0; i < size; i++) {
+      crc_ = static_cast<std::uint16_t>(crc_ << 8) ^
+             kTable[(crc_ >> 8 ^ data[i]) & 0xFF];
+    }
+  }
+
+  constexpr auto Get() const -> std::uint16_t { return crc_; }
+
+  static constexpr auto Compute(std::uint8_t const *data, std::size_t size)
+      -> std::uint16_t {
+    Crc16 crc;
+    crc.Update(data, size);
+    return crc.Get();
+  }
+};
+
+static_assert([] {
+  constexpr std::uint8_t kCheck[] = {'1', '2', '3', '4', '5',
+                                     '6', '7', '8', '9'};
+  return Crc16::Compute(kCheck, sizeof(kCheck)) == 0x29B1;
+}());
+}  // namespace robobus::internal
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace robobus::internal {
+template <typename Signature, std::size_t InlineSize = 4 * sizeof(void*)>
+class Delegate;
+
+/// @brief 呼び出し可能オブジェクトを内部の領域に格納する std::function の代わり
+/// @details 格納できるのは InlineSize に収まり，ムーブ時に例外を投げないものに限る
+///  (収まらない場合はコンパイルエラー)．そのため構築・呼び出しでメモリ確保は発生しない
+/// @tparam R 戻り値の型
+/// @tparam Args 引数の型
+/// @tparam InlineSize 内部に持つ領域の大きさ
+template <typename R, typename... Args, std::size_t InlineSize>
+class Delegate<R(Args...), InlineSize> {
+  struct Ops {
+    R (*invoke)(void* storage, Args... args);
+    void (*move)(void* from, void* to);
+    void (*destroy)(void* storage);
+  };
+
+  template <typename F>
+  static constexpr Ops kOps = {
+      [](void* storage, Args... args) -> R {
+        return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+      },
+      [](void* from, void* to) {
+        new (to) F(std::move(*static_cast<F*>(from)));
+        static_cast<F*>(from)->~F();
+      },
+      [](void* storage) { static_cast<F*>(storage)->~F(); },
+  };
+
+  alignas(std::max_align_t) unsigned char storage_[InlineSize];
+  Ops const* ops_ = nullptr;
+
+ public:
+  Delegate() = default;
+
+  template <typename F>
+    requires(!std::is_same_v<std::decay_t<F>, Delegate> &&
+             std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+  Delegate(F&& f) {  // NOLINT(google-explicit-constructor)
+    using Fn = std::decay_t<F>;
+    static_assert(sizeof(Fn) <= InlineSize,
+                  "Delegate: closure is too large (capture by reference or "
+                  "increase InlineSize)");
+    static_assert(alignof(Fn) <= alignof(std::max_align_t));
+    static_assert(std::is_nothrow_move_constructible_v<Fn>);
+
+    new (storage_) Fn(std::forward<F>(f));
+    ops_ = &kOps<Fn>;
+  }
+
+  Delegate(Delegate const&) = delete;
+  Delegate& operator=(Delegate const&) = delete;
+
+  Delegate(Delegate&& other) noexcept : ops_(other.ops_) {
+    if (ops_ != nullptr) {
+      ops_->move(other.storage_, storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  Delegate& operator=(Delegate&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      ops_ = other.ops_;
+      if (ops_ != nullptr) {
+        ops_->move(other.storage_, storage_);
+        other.ops_ = nullptr;
+      }
+    }
+
+    return *this;
+  }
+
+  ~Delegate() { Reset(); }
+
+  /// @brief 格納しているものを破棄して空にする
+  void Reset() {
+    if (ops_ != nullptr) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  auto operator()(Args... args) -> R {
+    return ops_->invoke(storage_, std::forward<Args>(args)...);
+  }
+};
+}  // namespace robobus::internal
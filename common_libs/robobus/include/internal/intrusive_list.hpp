@@ -0,0 +1,120 @@
+#pragma once
+
+namespace robobus::internal {
+/// @brief 侵入型リストの要素に埋め込むフック
+/// @details 1 つのオブジェクトを複数のリストに所属させる場合は Tag で区別する
+/// @tparam Tag フックを区別するための型
+template <typename Tag = void>
+class IntrusiveListHook {
+  template <typename T, typename U>
+  friend class IntrusiveList;
+
+  IntrusiveListHook* prev_ = nullptr;
+  IntrusiveListHook* next_ = nullptr;
+
+ public:
+  IntrusiveListHook() = default;
+  IntrusiveListHook(IntrusiveListHook const&) = delete;
+  IntrusiveListHook& operator=(IntrusiveListHook const&) = delete;
+
+  ~IntrusiveListHook() { Unlink(); }
+
+  auto IsLinked() const -> bool { return next_ != nullptr; }
+
+  /// @brief 所属しているリストから外す (O(1))
+  void Unlink() {
+    if (!IsLinked()) {
+      return;
+    }
+
+    prev_->next_ = next_;
+    next_->prev_ = prev_;
+    prev_ = nullptr;
+    next_ = nullptr;
+  }
+};
+
+/// @brief 侵入型の双方向リスト
+/// @details 要素側に埋め込まれたフックで連結するため，追加・削除でメモリ確保が発生しない．
+///  要素の寿命はリストが管理しない (要素の破棄時に自動でリストから外れる)
+/// @tparam T 要素の型 (IntrusiveListHook<Tag> を継承していること)
+/// @tparam Tag フックを区別するための型
+template <typename T, typename Tag = void>
+class IntrusiveList {
+  using Hook = IntrusiveListHook<Tag>;
+
+  Hook head_;
+
+  static auto ToElement(Hook* hook) -> T* {
+    return static_cast<T*>(hook);
+  }
+
+ public:
+  IntrusiveList() {
+    head_.prev_ = &head_;
+    head_.next_ = &head_;
+  }
+
+  IntrusiveList(IntrusiveList const&) = delete;
+  IntrusiveList& operator=(IntrusiveList const&) = delete;
+
+  ~IntrusiveList() { Clear(); }
+
+  auto Empty() const -> bool { return head_.next_ == &head_; }
+
+  /// @brief 末尾に追加する (既に他のリストに所属している場合はそこから外す)
+  void PushBack(T& element) {
+    Hook* hook = &element;
+    hook->Unlink();
+
+    hook->prev_ = head_.prev_;
+    hook->next_ = &head_;
+    head_.prev_->next_ = hook;
+    head_.prev_ = hook;
+  }
+
+  /// @brief 先頭の要素を取り出す
+  /// @return 空の場合 nullptr
+  auto PopFront() -> T* {
+    if (Empty()) {
+      return nullptr;
+    }
+
+    auto hook = head_.next_;
+    hook->Unlink();
+
+    return ToElement(hook);
+  }
+
+  /// @brief other の要素をすべて末尾へ移動する (O(1))
+  void Splice(IntrusiveList& other) {
+    if (other.Empty()) {
+      return;
+    }
+
+    auto first = other.head_.next_;
+    auto last = other.head_.prev_;
+    other.head_.next_ = &other.head_;
+    other.head_.prev_ = &other.head_;
+
+    first->prev_ = head_.prev_;
+    last->next_ = &head_;
+    head_.prev_->next_ = first;
+    head_.prev_ = last;
+  }
+
+  /// @brief すべての要素をリストから外す
+  void Clear() {
+    while (PopFront() != nullptr) {
+    }
+  }
+
+  /// @brief すべての要素に対して f を呼び出す (f の中で要素を外してはならない)
+  template <typename F>
+  void ForEach(F&& f) {
+    for (auto hook = head_.next_; hook != &head_; hook = hook->next_) {
+      f(*ToElement(hook));
+    }
+  }
+};
+}  // namespace robobus::internal
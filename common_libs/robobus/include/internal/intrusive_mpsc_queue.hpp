@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+
+namespace robobus::internal {
+/// @brief IntrusiveMpscQueue の要素に埋め込むフック
+/// @tparam Tag フックを区別するための型
+template <typename Tag = void>
+class IntrusiveMpscHook {
+  template <typename T, typename U>
+  friend class IntrusiveMpscQueue;
+
+  IntrusiveMpscHook* next_ = nullptr;
+  /// キューに積まれていて，まだ取り出されていない場合 true
+  std::atomic<bool> queued_{false};
+
+ public:
+  IntrusiveMpscHook() = default;
+  IntrusiveMpscHook(IntrusiveMpscHook const&) = delete;
+  IntrusiveMpscHook& operator=(IntrusiveMpscHook const&) = delete;
+
+  /// @brief キューに積まれていて，まだ取り出されていないか
+  auto IsQueued() const -> bool {
+    return queued_.load(std::memory_order_acquire);
+  }
+};
+
+/// @brief 要素に埋め込んだフックで連結する，容量制限の無いロックフリーの MPSC キュー
+/// @details Push() は先頭への CAS だけなので割り込みからも呼び出せ，満杯で失敗することがない．
+///  既に積まれている要素を積み直しても 1 つにまとまる．
+///  取り出しは単一の消費者 (Loop) が Drain() でまとめて行い，積まれた順に渡す．
+///  積まれている間に要素を破棄してはならない
+/// @tparam T 要素の型 (IntrusiveMpscHook<Tag> を継承していること)
+/// @tparam Tag フックを区別するための型
+template <typename T, typename Tag = void>
+class IntrusiveMpscQueue {
+  using Hook = IntrusiveMpscHook<Tag>;
+
+  static_assert(std::atomic<Hook*>::is_always_lock_free);
+
+  /// 最後に積まれた要素 (積まれた順とは逆向きに連結される)
+  std::atomic<Hook*> head_{nullptr};
+
+ public:
+  IntrusiveMpscQueue() = default;
+  IntrusiveMpscQueue(IntrusiveMpscQueue const&) = delete;
+  IntrusiveMpscQueue& operator=(IntrusiveMpscQueue const&) = delete;
+
+  /// @brief 要素を積む (割り込み・他スレッドから呼び出せる)
+  /// @return 新しく積んだ場合 true (既に積まれていた場合 false)
+  auto Push(T& element) -> bool {
+    Hook* hook = &element;
+    if (hook->queued_.exchange(true, std::memory_order_acq_rel)) {
+      return false;
+    }
+
+    auto head = head_.load(std::memory_order_relaxed);
+    do {
+      hook->next_ = head;
+    } while (!head_.compare_exchange_weak(head, hook, std::memory_order_release,
+                                          std::memory_order_relaxed));
+
+    return true;
+  }
+
+  /// @brief 積まれている要素を全て取り出し，積まれた順に f に渡す (消費者のみ)
+  /// @details f を呼ぶ前に要素の印を外すので，f の中やその後で積み直せる
+  template <typename F>
+  void Drain(F&& f) {
+    auto hook = head_.exchange(nullptr, std::memory_order_acquire);
+
+    // 積まれた順に並べ直す
+    Hook* ordered = nullptr;
+    while (hook != nullptr) {
+      auto next = hook->next_;
+      hook->next_ = ordered;
+      ordered = hook;
+      hook = next;
+    }
+
+    while (ordered != nullptr) {
+      auto next = ordered->next_;
+      ordered->next_ = nullptr;
+      ordered->queued_.store(false, std::memory_order_release);
+      f(*static_cast<T*>(ordered));
+      ordered = next;
+    }
+  }
+
+  /// @brief 取り出せる要素が無いか
+  auto Empty() const -> bool {
+    return head_.load(std::memory_order_acquire) == nullptr;
+  }
+};
+}  // namespace robobus::internal
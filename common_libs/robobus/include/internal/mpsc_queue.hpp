@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <type_traits>
+
+namespace robobus::internal {
+/// @brief 固定長・ロックフリーの多生産者単一消費者キュー
+/// @details 各セルに世代番号を持たせたリングバッファ (D. Vyukov の bounded queue)．
+///  TryPush() は複数のスレッド・割り込みから同時に呼び出せ，待ち合わせを行わない．
+///  TryPop() は単一の消費者 (Loop) からのみ呼び出すこと
+/// @tparam T 要素の型 (割り込みから書き込むため trivially copyable に限る)
+/// @tparam Capacity 要素数 (2 の冪)
+template <typename T, std::size_t Capacity>
+class MpscQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "MpscQueue capacity must be a power of two");
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(std::atomic<std::size_t>::is_always_lock_free);
+
+  static constexpr std::size_t kMask = Capacity - 1;
+
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    T data;
+  };
+
+  Cell cells_[Capacity];
+  std::atomic<std::size_t> enqueue_pos_{0};
+  std::size_t dequeue_pos_ = 0;
+
+  static auto Diff(std::size_t a, std::size_t b) -> std::intptr_t {
+    return static_cast<std::intptr_t>(a - b);
+  }
+
+ public:
+  MpscQueue() {
+    for (std::size_t i = 0; i < Capacity; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscQueue(MpscQueue const &) = delete;
+  MpscQueue &operator=(MpscQueue const &) = delete;
+
+  /// @brief 要素を追加する (割り込みから呼び出せる)
+  /// @return 満杯の場合 false
+  auto TryPush(T const &value) -> bool {
+    auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+
+    while (true) {
+      auto &cell = cells_[pos & kMask];
+      auto diff = Diff(cell.sequence.load(std::memory_order_acquire), pos);
+
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          cell.data = value;
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// @brief count 個の要素を連続した位置に 1 度に追加する (割り込みから呼び出せる)
+  /// @details fill(element, i) で i 番目の要素を書き込む．先頭の要素を最後に
+  ///  公開するので，消費者が先頭を取り出せた時には残りも続けて取り出せ，
+  ///  間に他の要素が挟まることもない．可変長の記録を複数の要素に分けて積むためのもの
+  /// @param count 1 以上 Capacity 以下
+  /// @return 空きが足りない場合 false
+  template <typename F>
+  auto TryPush(std::size_t count, F &&fill) -> bool {
+    auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+
+    // 消費者は順に空けていくので，最後の位置が空いていれば途中も空いている
+    while (true) {
+      auto &last = cells_[(pos + count - 1) & kMask];
+      auto diff =
+          Diff(last.sequence.load(std::memory_order_acquire), pos + count - 1);
+
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + count,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    for (std::size_t i = 1; i < count; i++) {
+      auto &cell = cells_[(pos + i) & kMask];
+      fill(cell.data, i);
+      cell.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+
+    auto &first = cells_[pos & kMask];
+    fill(first.data, std::size_t{0});
+    first.sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief 先頭の要素を取り出す (消費者のみ)
+  /// @return 空の場合 (もしくは書き込み途中の場合) false
+  auto TryPop(T &out) -> bool {
+    auto &cell = cells_[dequeue_pos_ & kMask];
+    auto diff = Diff(cell.sequence.load(std::memory_order_acquire),
+                     dequeue_pos_ + 1);
+    if (diff < 0) {
+      return false;
+    }
+
+    out = cell.data;
+    cell.sequence.store(dequeue_pos_ + Capacity, std::memory_order_release);
+    dequeue_pos_++;
+
+    return true;
+  }
+
+  /// @brief 取り出せる要素が無いか (消費者のみ)
+  auto Empty() const -> bool {
+    auto const &cell = cells_[dequeue_pos_ & kMask];
+    return Diff(cell.sequence.load(std::memory_order_acquire),
+                dequeue_pos_ + 1) < 0;
+  }
+};
+}  // namespace robobus::internal
@@ -1,20 +1,51 @@
 #pragma once
 
+#include <cstdint>
+
+#include <algorithm>
 #include <optional>
 
+#include "rtt_estimator.hpp"
 #include "signal.hpp"
 
 namespace robobus::internal {
+/// @brief MultiUpdatable の再送に関する統計情報
+struct RetransmitStats {
+  /// Update() の回数
+  std::uint32_t updates = 0;
+  /// タイマーによる再送の回数
+  std::uint32_t retransmits = 0;
+  /// Reset() (相手からの確認) の回数
+  std::uint32_t acks = 0;
+  /// RTT を計測できた回数 (再送した更新は Karn のアルゴリズムに従い除く)
+  std::uint32_t rtt_samples = 0;
+  /// 計測した RTT の最大値 [s]
+  float max_rtt_s = 0;
+};
+
 /**
  * @brief データの更新を管理するクラス
- * @details 更新操作を任意の型に付随することができる
+ * @details 更新操作を任意の型に付随することができる．
+ *  Reset() されるまで再送し続けるが，再送間隔は Update() から Reset() までの
+ *  時間 (RTT) から RFC 6298 と同じ方法 (SRTT/RTTVAR) で求め，
+ *  再送するたびに上限まで倍にする (指数バックオフ)
  */
 template <typename T>
 class MultiUpdatable {
-  static constexpr const float kTimeout_s = 10E-3f;  // 10ms
+  RttEstimator rtt_;
 
   bool need_update_ = false;
-  float timer_ = kTimeout_s;
+  float timer_ = 0;
+
+  /// Update() からの経過時間 [s]
+  float elapsed_s_ = 0;
+  /// 今回の更新を再送したか (再送した場合は RTT を計測しない)
+  bool retransmitted_ = false;
+
+  /// 連続して再送した回数
+  std::uint8_t backoff_ = 0;
+
+  RetransmitStats stats_;
 
   std::optional<T> data_ = std::nullopt;
 
@@ -23,19 +54,24 @@ class MultiUpdatable {
  public:
   internal::SignalRx<T> updated;
 
-  explicit MultiUpdatable(T const &data)
-      : data_(data),
+  explicit MultiUpdatable(T const &data, RetransmitConfig config = {})
+      : rtt_(config),
+        data_(data),
         updated_tx(std::make_shared<internal::Signal<T>>()),
         updated(updated_tx) {}
 
-  MultiUpdatable()
-      : updated_tx(std::make_shared<internal::Signal<T>>()),
+  explicit MultiUpdatable(RetransmitConfig config = {})
+      : rtt_(config),
+        updated_tx(std::make_shared<internal::Signal<T>>()),
         updated(updated_tx) {}
 
   /// @brief データに変化があったことを通知
   void Update() {
     need_update_ = true;
-    timer_ = 0;
+    elapsed_s_ = 0;
+    retransmitted_ = false;
+    timer_ = rtt_.Timeout(backoff_);
+    stats_.updates++;
 
     if (data_ != std::nullopt) {
       updated_tx.Fire(*data_);
@@ -43,7 +79,20 @@ class MultiUpdatable {
   }
 
   /// @brief データの更新が正常に行われたことを通知
-  void Reset() { need_update_ = false; }
+  void Reset() {
+    if (!need_update_) {
+      return;
+    }
+    need_update_ = false;
+    stats_.acks++;
+
+    if (!retransmitted_) {
+      rtt_.Sample(elapsed_s_);
+      stats_.rtt_samples++;
+      stats_.max_rtt_s = std::max(stats_.max_rtt_s, elapsed_s_);
+    }
+    backoff_ = 0;
+  }
 
   /// @param delta_time_s 前回の Tick() 呼び出しからの経過時間 [s]
   void Tick(float delta_time_s) {
@@ -51,13 +100,32 @@ class MultiUpdatable {
       return;
     }
 
+    elapsed_s_ += delta_time_s;
     timer_ -= delta_time_s;
     if (timer_ <= 0) {
-      timer_ = kTimeout_s;
+      if (!rtt_.AtLimit(backoff_)) {
+        backoff_++;
+      }
+      timer_ = rtt_.Timeout(backoff_);
+      retransmitted_ = true;
+      stats_.retransmits++;
+
       if (data_ != std::nullopt) updated_tx.Fire(*data_);
     }
   }
 
+  /// @brief 現在の再送間隔 (バックオフを含む) [s]
+  auto RetransmitTimeout() const -> float { return rtt_.Timeout(backoff_); }
+
+  /// @brief 平滑化した RTT [s] (計測値が無い場合 std::nullopt)
+  auto SmoothedRtt() const -> std::optional<float> {
+    return rtt_.SmoothedRtt();
+  }
+
+  auto Stats() const -> RetransmitStats const & { return stats_; }
+
+  void ResetStats() { stats_ = {}; }
+
   std::optional<T> &GetOptional() { return data_; }
 
   T &operator*() { return *data_; }
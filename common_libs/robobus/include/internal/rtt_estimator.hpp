@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+#include <algorithm>
+#include <optional>
+
+namespace robobus::internal {
+/// @brief 再送タイマーの設定
+struct RetransmitConfig {
+  /// RTT の計測値が無い時の再送間隔 [s]
+  float initial_rto_s = 10E-3f;
+  /// 再送間隔の下限 [s] (Tick() の粒度より大きくすること)
+  float min_rto_s = 1E-3f;
+  /// 指数バックオフを含めた再送間隔の上限 [s]
+  float max_rto_s = 200E-3f;
+};
+
+/// @brief RTT の計測値から再送間隔を求める
+/// @details RFC 6298 と同じく SRTT/RTTVAR を更新し，
+///  RTO = SRTT + max(min_rto, 4 * RTTVAR) とする．
+///  再送した送信の計測値は使わないこと (Karn のアルゴリズム)
+class RttEstimator {
+  RetransmitConfig config_;
+
+  std::optional<float> srtt_s_ = std::nullopt;
+  float rttvar_s_ = 0;
+  float rto_s_;
+
+ public:
+  explicit RttEstimator(RetransmitConfig config = {})
+      : config_(config), rto_s_(config.initial_rto_s) {}
+
+  void Sample(float rtt_s) {
+    if (!srtt_s_.has_value()) {
+      srtt_s_ = rtt_s;
+      rttvar_s_ = rtt_s / 2;
+    } else {
+      auto error = *srtt_s_ - rtt_s;
+      rttvar_s_ = 0.75f * rttvar_s_ + 0.25f * (error < 0 ? -error : error);
+      srtt_s_ = 0.875f * *srtt_s_ + 0.125f * rtt_s;
+    }
+
+    rto_s_ = std::clamp(*srtt_s_ + std::max(config_.min_rto_s, 4 * rttvar_s_),
+                        config_.min_rto_s, config_.max_rto_s);
+  }
+
+  /// @brief 再送タイマーが切れた時に，次の計測値までの再送間隔を倍にする
+  /// @details 全ての送信が再送になると Karn のアルゴリズムにより計測値が
+  ///  得られなくなるため，RFC 6298 (5.5) と同じく間隔そのものを延ばしておく．
+  ///  これを使う場合は Timeout() に backoff を渡さないこと (二重に倍になる)
+  void Backoff() { rto_s_ = std::min(rto_s_ * 2, config_.max_rto_s); }
+
+  /// @brief backoff 回連続して再送した後の再送間隔 (上限まで倍にしていく)
+  /// @details 送信ごとに backoff を数える MultiUpdatable 用．
+  ///  Backoff() と併用しないこと
+  auto Timeout(std::uint8_t backoff = 0) const -> float {
+    auto timeout = rto_s_;
+    for (int i = 0; i < backoff && timeout < config_.max_rto_s; i++) {
+      timeout *= 2;
+    }
+
+    return std::min(timeout, config_.max_rto_s);
+  }
+
+  /// @brief Timeout(backoff) が上限に達しているか
+  auto AtLimit(std::uint8_t backoff) const -> bool {
+    return config_.max_rto_s <= Timeout(backoff);
+  }
+
+  /// @brief 平滑化した RTT [s] (計測値が無い場合 std::nullopt)
+  auto SmoothedRtt() const -> std::optional<float> { return srtt_s_; }
+};
+}  // namespace robobus::internal
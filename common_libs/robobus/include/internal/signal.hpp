@@ -1,8 +1,17 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <type_traits>
 #include <utility>
 #include <vector>
-#include <functional>
+
+#include <robotics/platform/panic.hpp>
+
+#include "delegate.hpp"
+#include "intrusive_list.hpp"
 
 namespace robobus::internal {
 
@@ -12,6 +21,54 @@ class Signal;
 template <typename T>
 class SignalRx;
 
+struct SignalWaiterTag;
+
+/// @brief Connect() した Slot を指すハンドル
+/// @details Signal へのポインタと Slot の番号・世代の組で表すため，Disconnect() は
+///  O(1) で参照カウントにも触れず，既に外された (もしくは再利用された) Slot を
+///  誤って外すこともない．
+///  Signal の寿命は追わないので，Disconnect() は Signal が生きている間に呼ぶこと
+///  (Slot の持ち主が Signal を送る側を shared_ptr などで保持していれば満たされる)．
+///  Disconnect() せずに捨てるだけなら Signal より長生きしても構わない
+/// @tparam T Signal が通知するデータの型
+template <typename T>
+class SignalConnection {
+  Signal<T>* signal_ = nullptr;
+  std::uint16_t index_ = 0;
+  std::uint16_t generation_ = 0;
+
+ public:
+  SignalConnection() = default;
+
+  SignalConnection(Signal<T>& signal, std::uint16_t index,
+                   std::uint16_t generation)
+      : signal_(&signal), index_(index), generation_(generation) {}
+
+  /// @brief 接続に成功したか (Signal が破棄されていなかったか)
+  explicit operator bool() const { return signal_ != nullptr; }
+
+  /// @brief Slot を外す (2 回目以降は何もしない)
+  void Disconnect() {
+    if (signal_ != nullptr) {
+      signal_->Disconnect(index_, generation_);
+    }
+    signal_ = nullptr;
+  }
+};
+
+/// @brief 次の Fire を 1 回だけ待つもの
+/// @details Signal に侵入型リストとして登録されるため，登録時にメモリ確保は発生しない．
+///  Fire されるとリストから外されてから Notify() が呼ばれる
+/// @tparam T Signal が通知するデータの型
+template <typename T>
+class SignalWaiter : public IntrusiveListHook<SignalWaiterTag> {
+ public:
+  virtual void Notify(T const& data) = 0;
+
+ protected:
+  ~SignalWaiter() = default;
+};
+
 /// @brief Signal が通知するデータを送信するためのクラス
 /// @tparam T Signal が通知するデータの型
 template <typename T>
@@ -48,11 +105,30 @@ class SignalRx {
   SignalRx(std::shared_ptr<Signal<T>> signal) : signal_(signal) {}
 
   /// @brief Signal が通知するデータを受け取る
-  /// @param slot Signal が通知するデータを受け取る関数
-  /// @return 接続に成功した場合 true, 失敗した場合 false
-  bool Connect(std::function<void(T const&)> slot) {
+  /// @param slot Signal が通知するデータを受け取る関数．
+  ///  Signal<T>::kSlotSize (ポインタ 4 つ分．STM32 では 16 バイト) に収まること．
+  ///  収まらない場合は状態を 1 つの構造体にまとめ，そのポインタだけをキャプチャする
+  /// @return Slot を外すためのハンドル (失敗した場合は false に変換される)
+  template <typename F>
+  auto Connect(F&& slot) -> SignalConnection<T> {
+    static_assert(sizeof(std::decay_t<F>) <= Signal<T>::kSlotSize,
+                  "SignalRx::Connect: slot is larger than Signal<T>::kSlotSize "
+                  "(4 pointers, 16 bytes on STM32); capture a single pointer "
+                  "instead");
+
     if (auto signal = signal_.lock()) {
-      signal->Connect(slot);
+      return signal->Connect(std::forward<F>(slot));
+    } else {
+      return {};
+    }
+  }
+
+  /// @brief 次の Fire を 1 回だけ待つ
+  /// @param waiter Fire 時に通知を受けるもの
+  /// @return 登録に成功した場合 true, 失敗した場合 false
+  bool AddWaiter(SignalWaiter<T>& waiter) {
+    if (auto signal = signal_.lock()) {
+      signal->AddWaiter(waiter);
       return true;
     } else {
       return false;
@@ -63,23 +139,119 @@ class SignalRx {
 /// @brief Signal(クラスを超えて通知するためのもの)
 /// ちょっと高級な割り込みみたいな
 /// @details Signal は Slot と呼ばれる関数を登録し、Fire
-/// することで登録された関数をすべて呼び出すことができる
+/// することで登録された関数をすべて呼び出すことができる．
+/// Slot は内部領域に格納され `T const&` でデータを受け取るため，
+/// Fire でメモリ確保やデータの複製は発生しない．
+/// Fire 中の Disconnect は可能だが，Fire 中に Connect してはならない (panic する)
 ///
 /// @tparam T Signal が通知するデータの型
 template <typename T>
 class Signal {
  public:
-  std::vector<std::function<void(T)>> slots;
+  /// @brief Slot に格納できる関数オブジェクトの大きさ
+  static constexpr std::size_t kSlotSize = 4 * sizeof(void*);
+
+  using Slot = Delegate<void(T const&), kSlotSize>;
 
  private:
-  /// @brief Slot を登録する
-  void Connect(std::function<void(T const&)> slot) { slots.push_back(slot); }
+  enum class SlotState : std::uint8_t {
+    kFree,
+    kActive,
+    /// Fire 中に外されたもの (Fire の後に破棄する)
+    kDisconnected,
+  };
+
+  struct Entry {
+    Slot slot;
+    std::uint16_t generation = 0;
+    SlotState state = SlotState::kFree;
+  };
+
+  std::vector<Entry> slots_;
+  std::vector<std::uint16_t> free_slots_;
+  int firing_ = 0;
+  bool has_disconnected_ = false;
+
+  IntrusiveList<SignalWaiter<T>, SignalWaiterTag> waiters_;
+
+  /// @brief Slot を登録する (空いている番号があれば再利用する)
+  /// @details Fire 中は slots_ を走査しているので，呼び出すと panic する
+  template <typename F>
+  auto Connect(F&& slot) -> SignalConnection<T> {
+    if (firing_ != 0) {
+      robotics::system::panic("Signal::Connect must not be called during Fire");
+    }
+
+    std::uint16_t index;
+    if (free_slots_.empty()) {
+      index = static_cast<std::uint16_t>(slots_.size());
+      slots_.emplace_back();
+    } else {
+      index = free_slots_.back();
+      free_slots_.pop_back();
+    }
+
+    auto& entry = slots_[index];
+    entry.slot = Slot(std::forward<F>(slot));
+    entry.state = SlotState::kActive;
+
+    return SignalConnection<T>(*this, index, entry.generation);
+  }
+
+  void Release(std::uint16_t index) {
+    auto& entry = slots_[index];
+    entry.slot.Reset();
+    entry.state = SlotState::kFree;
+    entry.generation++;
+    free_slots_.push_back(index);
+  }
+
+  void Disconnect(std::uint16_t index, std::uint16_t generation) {
+    if (slots_.size() <= index) {
+      return;
+    }
+
+    auto& entry = slots_[index];
+    if (entry.generation != generation || entry.state != SlotState::kActive) {
+      return;
+    }
+
+    if (firing_ != 0) {
+      // 呼び出し中の Slot を破棄しないよう Fire の後まで待つ
+      entry.state = SlotState::kDisconnected;
+      has_disconnected_ = true;
+      return;
+    }
+
+    Release(index);
+  }
+
+  void AddWaiter(SignalWaiter<T>& waiter) { waiters_.PushBack(waiter); }
 
   /// @brief 登録された Slot をすべて呼び出す (Signal が発火する)
   /// @param data Signal が通知するデータ
   void Fire(T const& data) {
-    for (auto& slot : slots) {
-      slot(data);
+    firing_++;
+    for (auto& entry : slots_) {
+      if (entry.state == SlotState::kActive) {
+        entry.slot(data);
+      }
+    }
+    firing_--;
+
+    if (firing_ == 0 && has_disconnected_) {
+      has_disconnected_ = false;
+      for (std::size_t i = 0; i < slots_.size(); i++) {
+        if (slots_[i].state == SlotState::kDisconnected) {
+          Release(static_cast<std::uint16_t>(i));
+        }
+      }
+    }
+
+    IntrusiveList<SignalWaiter<T>, SignalWaiterTag> waiters;
+    waiters.Splice(waiters_);
+    while (auto waiter = waiters.PopFront()) {
+      waiter->Notify(data);
     }
   }
 
@@ -89,10 +261,17 @@ class Signal {
   template <typename U>
   friend class SignalRx;
 
+  template <typename U>
+  friend class SignalConnection;
+
   template <typename U>
   friend class SignalView;
 
  public:
+  /// @brief 登録されている Slot の数
+  auto SlotCount() const -> std::size_t {
+    return slots_.size() - free_slots_.size();
+  }
 };
 
 }  // namespace robobus::internal
\ No newline at end of file
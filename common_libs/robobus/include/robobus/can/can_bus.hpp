@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+
+#include "../../internal/signal.hpp"
+#include "../../types/can_frame.hpp"
+
+namespace robobus::can {
+/// @brief フレームを値のまま送受信する CAN バス
+/// @details 受信したフレームは rx に const 参照で通知されるので，
+///  送受信の経路でメモリ確保は発生しない
+/// @tparam Frame types::CanFrame もしくは types::CanFdFrame
+template <typename Frame>
+class BasicCanBus {
+  internal::SignalTx<Frame> rx_tx_{std::make_shared<internal::Signal<Frame>>()};
+
+ protected:
+  /// @brief 受信したフレームを rx に通知する (実装側が呼ぶ)
+  void Deliver(Frame const &frame) { rx_tx_.Fire(frame); }
+
+ public:
+  /// @brief 受信したフレーム (通知の間だけ有効)
+  internal::SignalRx<Frame> rx{rx_tx_};
+
+  virtual ~BasicCanBus() = default;
+
+  /// @return 送信キューに積めた場合 true
+  virtual auto Send(Frame const &frame) -> bool = 0;
+
+  /// @brief 受信したフレームの kExtended が実際の IDE を表すか
+  /// @details false の場合 (CANBase を経由するものなど) は ID の値から推測している
+  virtual auto PreservesIde() const -> bool { return true; }
+};
+
+using CanBus = BasicCanBus<types::CanFrame>;
+using CanFdBus = BasicCanBus<types::CanFdFrame>;
+}  // namespace robobus::can
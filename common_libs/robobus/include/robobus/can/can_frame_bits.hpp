@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../../types/can_frame.hpp"
+
+namespace robobus::can {
+/// @brief フレームのビット数 (ビットスタッフィング込み)
+/// @details Classic CAN は CRC15 を実際に計算し，SOF から CRC までの
+///  スタッフビットを数える．CAN FD は CRC を 0 とみなして動的スタッフビットを数え，
+///  CRC 部分の固定スタッフビットを加える．いずれも CRC デリミタ，ACK, EOF と
+///  フレーム間スペース (3bit) を含む
+struct CanFrameBits {
+  /// 調停ビットレートで送るビット数
+  std::uint32_t nominal = 0;
+  /// データビットレートで送るビット数 (BRS 付きの CAN FD のみ)
+  std::uint32_t data = 0;
+
+  template <std::size_t N>
+  static auto Of(types::BasicCanFrame<N> const &frame) -> CanFrameBits {
+    BitCounter bits;
+    auto extended = frame.IsExtended();
+    auto fd = frame.IsFd();
+    auto remote = !fd && types::HasFlag(frame.flags, types::CanFrameFlags::kRemote);
+    auto brs = fd && types::HasFlag(frame.flags, types::CanFrameFlags::kBitrateSwitch);
+
+    bits.Put(false);  // SOF
+    if (extended) {
+      bits.Put(frame.id >> 18, 11);
+      bits.Put(true);  // SRR
+      bits.Put(true);  // IDE
+      bits.Put(frame.id & 0x3FFFF, 18);
+    } else {
+      bits.Put(frame.id & 0x7FF, 11);
+    }
+
+    auto size = frame.size;
+    CanFrameBits result;
+    if (!fd) {
+      bits.Put(remote);
+      bits.Put(0, 2);  // 標準: IDE, r0 / 拡張: r1, r0
+      bits.Put(size, 4);
+      if (!remote) {
+        for (std::size_t i = 0; i < size; i++) {
+          bits.Put(frame.data[i], 8);
+        }
+      }
+      bits.PutCrc15();
+
+      // CRC デリミタ, ACK, ACK デリミタ, EOF, IFS
+      result.nominal = bits.Bits() + 1 + 2 + 7 + 3;
+      return result;
+    }
+
+    bits.Put(false);  // RRS
+    if (!extended) {
+      bits.Put(false);  // IDE
+    }
+    bits.Put(true);   // FDF
+    bits.Put(false);  // res
+    bits.Put(brs);
+    auto arbitration = bits.Bits();
+
+    auto dlc = types::CanLengthToDlc(size);
+    bits.Put(false);  // ESI
+    bits.Put(dlc, 4);
+    auto length = types::CanDlcToLength(dlc);
+    for (std::size_t i = 0; i < length; i++) {
+      bits.Put(i < size ? frame.data[i] : 0, 8);
+    }
+
+    // スタッフカウント (4bit) と CRC (17/21bit) に 4bit ごとの固定スタッフビット
+    auto crc = length <= 16 ? 17 : 21;
+    auto crc_field = 4 + crc + (4 + crc + 3) / 4;
+    auto data_phase = bits.Bits() - arbitration + crc_field + 1;  // CRC デリミタ
+
+    if (brs) {
+      result.nominal = arbitration + 2 + 7 + 3;
+      result.data = data_phase;
+    } else {
+      result.nominal = arbitration + data_phase + 2 + 7 + 3;
+    }
+
+    return result;
+  }
+
+ private:
+  /// @brief ビットを順に積み，スタッフビットと CRC15 を数える
+  class BitCounter {
+    std::uint32_t bits_ = 0;
+    std::uint32_t run_ = 0;
+    bool last_ = false;
+    std::uint16_t crc_ = 0;
+
+    void PutBit(bool bit, bool crc) {
+      if (crc) {
+        auto next = bit ^ ((crc_ >> 14) & 1);
+        crc_ = static_cast<std::uint16_t>((crc_ << 1) & 0x7FFF);
+        if (next) {
+          crc_ ^= 0x4599;
+        }
+      }
+
+      bits_++;
+      if (run_ != 0 && bit == last_) {
+        run_++;
+      } else {
+        last_ = bit;
+        run_ = 1;
+      }
+
+      if (run_ == 5) {
+        // 反転したスタッフビットが入り，次の連続の 1bit 目になる
+        bits_++;
+        last_ = !bit;
+        run_ = 1;
+      }
+    }
+
+   public:
+    void Put(bool bit) { PutBit(bit, true); }
+
+    /// @brief value の下位 count bit を上位から積む
+    void Put(std::uint32_t value, int count) {
+      for (int i = count - 1; 0 <= i; i--) {
+        PutBit(((value >> i) & 1) != 0, true);
+      }
+    }
+
+    void PutCrc15() {
+      auto crc = crc_;
+      for (int i = 14; 0 <= i; i--) {
+        PutBit(((crc >> i) & 1) != 0, false);
+      }
+    }
+
+    auto Bits() const -> std::uint32_t { return bits_; }
+  };
+};
+}  // namespace robobus::can
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#include <memory>
+#include <vector>
+
+#include <robotics/network/can_base.hpp>
+
+#include "can_bus.hpp"
+
+namespace robobus::can {
+/// @brief std::vector でやり取りする CANBase を CanBus として使うためのもの
+/// @details 送信は内部のバッファを使い回すので確保は最初の 1 回だけ．
+///  受信時の std::vector は CANBase 側で作られるため，この経路での確保は
+///  CANBase の実装が CanBus に移るまで残る
+class LegacyCanBus : public CanBus {
+  std::shared_ptr<robotics::network::CANBase> can_;
+  std::vector<std::uint8_t> tx_buffer_;
+
+ public:
+  explicit LegacyCanBus(std::shared_ptr<robotics::network::CANBase> can)
+      : can_(std::move(can)) {
+    tx_buffer_.reserve(types::CanFrame::kCapacity);
+
+    can_->OnRx([this](std::uint32_t id, std::vector<std::uint8_t> const &data) {
+      Deliver(
+          types::CanFrame::Create(id, data, types::InferFlagsFromId(id)));
+    });
+  }
+
+  LegacyCanBus(LegacyCanBus const &) = delete;
+  LegacyCanBus &operator=(LegacyCanBus const &) = delete;
+
+  auto Send(types::CanFrame const &frame) -> bool override {
+    auto data = frame.Data();
+    tx_buffer_.assign(data.begin(), data.end());
+    return can_->Send(frame.id, tx_buffer_) == 1;
+  }
+
+  /// @brief CANBase は IDE を伝えないので，kExtended は ID の値から推測したもの
+  auto PreservesIde() const -> bool override { return false; }
+
+  auto Base() const -> robotics::network::CANBase & { return *can_; }
+};
+}  // namespace robobus::can
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <robotics/network/can_base.hpp>
+
+#include "socket_can_bus.hpp"
+
+namespace robobus::can {
+/// @brief SocketCanBus を CANBase として使うためのもの
+/// @details Linux 上で SimpleCAN の代わりに使う．コールバックは bus の
+///  Process() (もしくは Receive() / Flush()) を呼んだスレッドから呼ばれる．
+///  OnTx は tx_done, OnIdle は tx_empty (送信待ちが空になった時) に呼ばれる
+class SocketCanBase : public robotics::network::CANBase {
+  using FrameCallback =
+      std::function<void(std::uint32_t, std::vector<std::uint8_t> const &)>;
+
+  std::shared_ptr<SocketCanBus> bus_;
+
+  FrameCallback rx_;
+  FrameCallback tx_;
+  std::function<void()> idle_;
+
+  internal::SignalConnection<types::CanFrame> rx_connection_;
+  internal::SignalConnection<types::CanFrame> tx_connection_;
+  internal::SignalConnection<std::size_t> idle_connection_;
+
+  /// コールバックに渡すためのバッファ (使い回す)
+  std::vector<std::uint8_t> buffer_;
+
+ public:
+  /// @param bus Open() 済みのバス
+  explicit SocketCanBase(std::shared_ptr<SocketCanBus> bus)
+      : bus_(std::move(bus)) {
+    buffer_.reserve(types::CanFrame::kCapacity);
+
+    rx_connection_ = bus_->rx.Connect([this](types::CanFrame const &frame) {
+      if (!rx_ || types::HasFlag(frame.flags, types::CanFrameFlags::kError)) {
+        return;
+      }
+
+      auto data = frame.Data();
+      buffer_.assign(data.begin(), data.end());
+      rx_(frame.id, buffer_);
+    });
+
+    tx_connection_ = bus_->tx_done.Connect([this](types::CanFrame const &frame) {
+      if (tx_) {
+        auto data = frame.Data();
+        buffer_.assign(data.begin(), data.end());
+        tx_(frame.id, buffer_);
+      }
+    });
+
+    idle_connection_ = bus_->tx_empty.Connect([this](std::size_t) {
+      if (idle_) {
+        idle_();
+      }
+    });
+  }
+
+  ~SocketCanBase() override {
+    rx_connection_.Disconnect();
+    tx_connection_.Disconnect();
+    idle_connection_.Disconnect();
+  }
+
+  SocketCanBase(SocketCanBase const &) = delete;
+  SocketCanBase &operator=(SocketCanBase const &) = delete;
+
+  void Init() override {}
+
+  /// @return 送信待ちに積めた場合 1 (SimpleCAN と同じ)
+  int Send(uint32_t id, std::vector<uint8_t> const &data) override {
+    auto flags = types::InferFlagsFromId(id);
+    return bus_->Send(types::CanFrame::Create(id, data, flags)) ? 1 : 0;
+  }
+
+  void OnRx(FrameCallback cb) override { rx_ = std::move(cb); }
+
+  void OnTx(FrameCallback cb) override { tx_ = std::move(cb); }
+
+  void OnIdle(std::function<void()> cb) override { idle_ = std::move(cb); }
+
+  float GetBusLoad() override { return bus_->BusLoad(); }
+
+  auto Bus() const -> SocketCanBus & { return *bus_; }
+};
+}  // namespace robobus::can
@@ -0,0 +1,548 @@
+#pragma once
+
+// Linux の SocketCAN (can0, vcan0 など) を使う実装．Linux 以外ではビルドできない
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <span>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "can_bus.hpp"
+#include "can_frame_bits.hpp"
+
+namespace robobus::can {
+struct SocketCanConfig {
+  /// 送信したフレームを同じホストの他のソケット (candump など) にも見せる
+  bool loopback = true;
+  /// 自分が送信したフレームを受け取り，実際にバスへ送られた時点で tx_done を通知する
+  /// (false の場合はカーネルが受け付けた時点で通知する)
+  bool receive_own = false;
+  /// エラーフレームを kError 付きのフレームとして rx に通知する
+  bool error_frames = false;
+  /// 受信時刻をカーネルから受け取る (対応していればハードウェアの時刻)
+  bool timestamps = true;
+  /// SO_RCVBUF [byte] (0 ならばカーネルの既定値)
+  int receive_buffer = 0;
+  /// バス負荷の見積もりに使うビットレート [bit/s]
+  std::uint32_t bitrate = 1000000;
+  std::uint32_t data_bitrate = 4000000;
+};
+
+struct SocketCanStats {
+  std::uint32_t rx_frames = 0;
+  std::uint32_t tx_frames = 0;
+  /// recvmmsg() / sendmmsg() を呼んだ回数 (1 回あたりのフレーム数の目安)
+  std::uint32_t rx_batches = 0;
+  std::uint32_t tx_batches = 0;
+  /// カーネルの送信キューが一杯で後回しにした回数
+  std::uint32_t tx_retries = 0;
+  /// カーネルに拒否されて捨てた送信フレームの数
+  std::uint32_t tx_dropped = 0;
+  /// 受信バッファが溢れてカーネルが捨てたフレームの数 (SO_RXQ_OVFL)
+  std::uint32_t rx_dropped = 0;
+};
+
+/// @brief SocketCAN の raw ソケットを使う CAN バス
+/// @details 送信したフレームは Flush() までまとめておき，1 回の sendmmsg() で送る．
+///  受信は Receive() で recvmmsg() を呼び，届いていた分をまとめて rx に通知する．
+///  どちらも非ブロッキングなので，Process() で待つか，Fd() を自前の
+///  poll / epoll に登録して呼ぶ．rx と tx_done は Receive() / Flush() を呼んだ
+///  スレッドから通知される
+/// @tparam Frame types::CanFrame もしくは types::CanFdFrame
+///  (CanFdFrame の場合は CAN_RAW_FD_FRAMES を有効にする)
+/// @tparam Batch 1 回の recvmmsg() / sendmmsg() で扱うフレームの最大数
+template <typename Frame, std::size_t Batch = 32>
+class BasicSocketCanBus : public BasicCanBus<Frame> {
+  static constexpr bool kFd = types::CanFrame::kCapacity < Frame::kCapacity;
+
+  /// SCM_TIMESTAMPING と SO_RXQ_OVFL を受け取るのに十分な大きさ
+  static constexpr std::size_t kControlSize =
+      CMSG_SPACE(sizeof(scm_timestamping)) + CMSG_SPACE(sizeof(std::uint32_t));
+
+  int fd_ = -1;
+  SocketCanConfig config_;
+
+  std::array<canfd_frame, Batch> rx_frames_{};
+  std::array<iovec, Batch> rx_iov_{};
+  std::array<std::array<char, kControlSize>, Batch> rx_control_{};
+  std::array<mmsghdr, Batch> rx_msgs_{};
+
+  /// Flush() を待っている送信フレーム (tx_done に渡すため元のフレームも持つ)
+  std::array<Frame, Batch> tx_queue_{};
+  std::array<canfd_frame, Batch> tx_frames_{};
+  std::array<iovec, Batch> tx_iov_{};
+  std::array<mmsghdr, Batch> tx_msgs_{};
+  std::size_t tx_count_ = 0;
+  /// Flush() で送り終え，送信待ちから取り除いた後に tx_done へ渡すフレーム
+  std::array<Frame, Batch> tx_done_queue_{};
+  /// Flush() の中 (tx_done の通知中を含む) か
+  bool flushing_ = false;
+
+  /// 失敗した任意の設定 (SO_TIMESTAMPING / SO_RXQ_OVFL) の -errno
+  int option_error_ = 0;
+
+  std::chrono::nanoseconds rx_timestamp_{0};
+  bool rx_hardware_timestamp_ = false;
+
+  SocketCanStats stats_;
+  /// 最後に BusLoad() を呼んでから見たフレームがバスを占有した時間 [ns] の合計
+  std::uint64_t load_busy_ns_ = 0;
+  std::chrono::steady_clock::time_point load_since_ =
+      std::chrono::steady_clock::now();
+
+  internal::SignalTx<Frame> tx_done_tx_{
+      std::make_shared<internal::Signal<Frame>>()};
+  internal::SignalTx<std::size_t> tx_empty_tx_{
+      std::make_shared<internal::Signal<std::size_t>>()};
+
+  static auto ToWire(Frame const &frame, canfd_frame &wire) -> std::size_t {
+    wire = {};
+    if (frame.IsExtended()) {
+      wire.can_id = (frame.id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+    } else {
+      wire.can_id = frame.id & CAN_SFF_MASK;
+    }
+    wire.len = frame.size;
+    std::memcpy(wire.data, frame.data.data(), frame.size);
+
+    if (!frame.IsFd()) {
+      if (types::HasFlag(frame.flags, types::CanFrameFlags::kRemote)) {
+        wire.can_id |= CAN_RTR_FLAG;
+      }
+      return CAN_MTU;
+    }
+
+    if (types::HasFlag(frame.flags, types::CanFrameFlags::kBitrateSwitch)) {
+      wire.flags |= CANFD_BRS;
+    }
+    return CANFD_MTU;
+  }
+
+  static auto FromWire(canfd_frame const &wire, std::size_t size) -> Frame {
+    auto flags = types::CanFrameFlags::kNone;
+    std::uint32_t id;
+    if (wire.can_id & CAN_ERR_FLAG) {
+      flags = types::CanFrameFlags::kError;
+      id = wire.can_id & CAN_ERR_MASK;
+    } else if (wire.can_id & CAN_EFF_FLAG) {
+      flags = types::CanFrameFlags::kExtended;
+      id = wire.can_id & CAN_EFF_MASK;
+    } else {
+      id = wire.can_id & CAN_SFF_MASK;
+    }
+
+    if (size == CANFD_MTU) {
+      flags = flags | types::CanFrameFlags::kFd;
+      if (wire.flags & CANFD_BRS) {
+        flags = flags | types::CanFrameFlags::kBitrateSwitch;
+      }
+    } else if (wire.can_id & CAN_RTR_FLAG) {
+      flags = flags | types::CanFrameFlags::kRemote;
+    }
+
+    return Frame::Create(
+        id, std::span<std::uint8_t const>(wire.data, wire.len), flags);
+  }
+
+  /// @brief 受信メッセージの制御データから時刻と溢れた数を取り出す
+  void ReadControl(msghdr &msg) {
+    rx_timestamp_ = std::chrono::nanoseconds{0};
+    rx_hardware_timestamp_ = false;
+
+    for (auto *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level != SOL_SOCKET) {
+        continue;
+      }
+
+      if (cmsg->cmsg_type == SO_TIMESTAMPING) {
+        scm_timestamping stamps;
+        std::memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+        // ts[0] がソフトウェア，ts[2] が生のハードウェアの時刻
+        auto const &ts = stamps.ts[2].tv_sec != 0 || stamps.ts[2].tv_nsec != 0
+                             ? stamps.ts[2]
+                             : stamps.ts[0];
+        rx_hardware_timestamp_ = &ts == &stamps.ts[2];
+        rx_timestamp_ = std::chrono::seconds{ts.tv_sec} +
+                        std::chrono::nanoseconds{ts.tv_nsec};
+      } else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+        // ソケットを開いてからの累計
+        std::memcpy(&stats_.rx_dropped, CMSG_DATA(cmsg),
+                    sizeof(stats_.rx_dropped));
+      }
+    }
+  }
+
+  void CountLoad(Frame const &frame) {
+    if (types::HasFlag(frame.flags, types::CanFrameFlags::kError)) {
+      return;
+    }
+
+    auto bits = CanFrameBits::Of(frame);
+    load_busy_ns_ += bits.nominal * 1000000000ull / config_.bitrate +
+                     bits.data * 1000000000ull / config_.data_bitrate;
+  }
+
+  /// @return 成功した場合 0, 失敗した場合 -errno
+  auto SetOption(int level, int name, int value) -> int {
+    if (::setsockopt(fd_, level, name, &value, sizeof(value)) != 0) {
+      return -errno;
+    }
+    return 0;
+  }
+
+ public:
+  /// @brief フレームがバスへ送られた (config.receive_own が false の場合は
+  ///  カーネルに受け付けられた) (通知の間だけ有効)
+  internal::SignalRx<Frame> tx_done{tx_done_tx_};
+  /// @brief tx_done を通知し終えた時点で送信待ちが空になった
+  ///  (引数はこの回に tx_done を通知したフレームの数)
+  internal::SignalRx<std::size_t> tx_empty{tx_empty_tx_};
+
+  BasicSocketCanBus() {
+    for (std::size_t i = 0; i < Batch; i++) {
+      rx_iov_[i] = {&rx_frames_[i], sizeof(canfd_frame)};
+      tx_iov_[i] = {&tx_frames_[i], 0};
+      rx_msgs_[i].msg_hdr.msg_iov = &rx_iov_[i];
+      rx_msgs_[i].msg_hdr.msg_iovlen = 1;
+      tx_msgs_[i].msg_hdr.msg_iov = &tx_iov_[i];
+      tx_msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+  }
+
+  BasicSocketCanBus(BasicSocketCanBus const &) = delete;
+  BasicSocketCanBus &operator=(BasicSocketCanBus const &) = delete;
+
+  ~BasicSocketCanBus() override { Close(); }
+
+  /// @brief インターフェースを開く
+  /// @param interface "can0", "vcan0" など
+  /// @return 成功した場合 0, 失敗した場合 -errno
+  auto Open(char const *interface, SocketCanConfig const &config = {}) -> int {
+    Close();
+    config_ = config;
+
+    auto index = ::if_nametoindex(interface);
+    if (index == 0) {
+      return -errno;
+    }
+
+    fd_ = ::socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+    if (fd_ < 0) {
+      auto error = -errno;
+      fd_ = -1;
+      return error;
+    }
+
+    // config で指定した動作に必要な設定は，失敗すれば開かない
+    auto error = 0;
+    if constexpr (kFd) {
+      error = SetOption(SOL_CAN_RAW, CAN_RAW_FD_FRAMES, 1);
+    }
+    if (error == 0) {
+      error = SetOption(SOL_CAN_RAW, CAN_RAW_LOOPBACK, config_.loopback);
+    }
+    if (error == 0) {
+      error =
+          SetOption(SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, config_.receive_own);
+    }
+    if (error == 0 && config_.error_frames) {
+      error = SetOption(SOL_CAN_RAW, CAN_RAW_ERR_FILTER, CAN_ERR_MASK);
+    }
+    if (error == 0 && config_.receive_buffer != 0) {
+      error = SetOption(SOL_SOCKET, SO_RCVBUF, config_.receive_buffer);
+    }
+    if (error != 0) {
+      Close();
+      return error;
+    }
+
+    // 時刻と溢れた数は無くても動くので，失敗は OptionError() で知らせる
+    option_error_ = 0;
+    if (config_.timestamps) {
+      // 対応していないドライバではハードウェアの時刻が 0 のままになる
+      if (auto result = SetOption(
+              SOL_SOCKET, SO_TIMESTAMPING,
+              SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+                  SOF_TIMESTAMPING_RX_HARDWARE |
+                  SOF_TIMESTAMPING_RAW_HARDWARE);
+          result != 0) {
+        option_error_ = result;
+      }
+    }
+    if (auto result = SetOption(SOL_SOCKET, SO_RXQ_OVFL, 1); result != 0) {
+      option_error_ = result;
+    }
+
+    sockaddr_can address{};
+    address.can_family = AF_CAN;
+    address.can_ifindex = static_cast<int>(index);
+    if (::bind(fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) !=
+        0) {
+      auto error = -errno;
+      Close();
+      return error;
+    }
+
+    load_busy_ns_ = 0;
+    load_since_ = std::chrono::steady_clock::now();
+    return 0;
+  }
+
+  void Close() {
+    if (fd_ < 0) {
+      return;
+    }
+
+    ::close(fd_);
+    fd_ = -1;
+    tx_count_ = 0;
+  }
+
+  auto IsOpen() const -> bool { return 0 <= fd_; }
+
+  /// @brief poll / epoll に登録するためのファイルディスクリプタ
+  auto Fd() const -> int { return fd_; }
+
+  /// @brief Open() で失敗した任意の設定 (SO_TIMESTAMPING / SO_RXQ_OVFL) の -errno
+  /// @details 0 でなければ RxTimestamp() や Stats().rx_dropped が得られない
+  ///  ことがある (全て成功していれば 0)
+  auto OptionError() const -> int { return option_error_; }
+
+  /// @brief 受け取る ID を絞る (CAN_RAW_FILTER．空ならば何も受け取らない)
+  /// @return 成功した場合 0, 失敗した場合 -errno
+  auto SetFilters(std::span<can_filter const> filters) -> int {
+    if (::setsockopt(fd_, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(),
+                     filters.size_bytes()) != 0) {
+      return -errno;
+    }
+    return 0;
+  }
+
+  /// @brief フレームを送信待ちに積む (実際に送るのは Flush())
+  /// @details 送信待ちが Batch 個に達していれば先に Flush() する
+  ///  (tx_done の通知中は Flush() しない)
+  /// @return カーネルの送信キューも一杯で積めなかった場合 false
+  auto Send(Frame const &frame) -> bool override {
+    if (fd_ < 0) {
+      return false;
+    }
+    if constexpr (!kFd) {
+      if (frame.IsFd()) {
+        return false;
+      }
+    }
+
+    if (tx_count_ == Batch) {
+      Flush();
+      if (tx_count_ == Batch) {
+        return false;
+      }
+    }
+
+    tx_queue_[tx_count_] = frame;
+    tx_iov_[tx_count_].iov_len = ToWire(frame, tx_frames_[tx_count_]);
+    tx_count_++;
+    return true;
+  }
+
+  /// @brief 送信待ちのフレームをまとめてカーネルに渡す
+  /// @details tx_done は送ったフレームを送信待ちから取り除いた後に通知するので，
+  ///  通知の中の Pending() は残りの数を返す．
+  ///  通知の中から Flush() を呼んでも何もしない
+  /// @return カーネルが受け付けたフレームの数
+  auto Flush() -> std::size_t {
+    if (flushing_) {
+      return 0;
+    }
+
+    std::size_t sent = 0;
+    std::size_t accepted = 0;
+    std::size_t done = 0;
+
+    while (sent < tx_count_) {
+      auto result = ::sendmmsg(fd_, &tx_msgs_[sent],
+                               static_cast<unsigned>(tx_count_ - sent),
+                               MSG_DONTWAIT);
+      stats_.tx_batches++;
+
+      if (0 < result) {
+        for (auto i = sent; i < sent + result; i++) {
+          stats_.tx_frames++;
+          if (!config_.receive_own) {
+            CountLoad(tx_queue_[i]);
+            tx_done_queue_[done++] = tx_queue_[i];
+          }
+        }
+        sent += result;
+        accepted += result;
+        continue;
+      }
+
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      if (result < 0 && (errno == EAGAIN || errno == ENOBUFS)) {
+        // キューが空いたら続きを送る (POLLOUT で分かる)
+        stats_.tx_retries++;
+        break;
+      }
+
+      // インターフェースが落ちている，FD に対応していないなど．先頭を捨てて続ける
+      stats_.tx_dropped++;
+      sent++;
+    }
+
+    if (sent != 0) {
+      std::copy(tx_queue_.begin() + sent, tx_queue_.begin() + tx_count_,
+                tx_queue_.begin());
+      std::copy(tx_frames_.begin() + sent, tx_frames_.begin() + tx_count_,
+                tx_frames_.begin());
+      for (std::size_t i = sent; i < tx_count_; i++) {
+        tx_iov_[i - sent].iov_len = tx_iov_[i].iov_len;
+      }
+      tx_count_ -= sent;
+    }
+
+    flushing_ = true;
+    for (std::size_t i = 0; i < done; i++) {
+      tx_done_tx_.Fire(tx_done_queue_[i]);
+    }
+    flushing_ = false;
+
+    if (done != 0 && tx_count_ == 0) {
+      tx_empty_tx_.Fire(done);
+    }
+
+    return accepted;
+  }
+
+  /// @brief 届いているフレームをまとめて受け取り rx (自分の送信は tx_done) に通知する
+  /// @return 受け取ったフレームの数
+  auto Receive() -> std::size_t {
+    std::size_t received = 0;
+    std::size_t own = 0;
+
+    while (true) {
+      for (std::size_t i = 0; i < Batch; i++) {
+        auto &hdr = rx_msgs_[i].msg_hdr;
+        hdr.msg_control = rx_control_[i].data();
+        hdr.msg_controllen = kControlSize;
+        hdr.msg_flags = 0;
+      }
+
+      auto result = ::recvmmsg(fd_, rx_msgs_.data(), Batch, MSG_DONTWAIT,
+                               nullptr);
+      if (result <= 0) {
+        break;
+      }
+      stats_.rx_batches++;
+
+      for (int i = 0; i < result; i++) {
+        auto &msg = rx_msgs_[i];
+        if (msg.msg_len != CAN_MTU && msg.msg_len != CANFD_MTU) {
+          continue;
+        }
+
+        ReadControl(msg.msg_hdr);
+        auto frame = FromWire(rx_frames_[i], msg.msg_len);
+        CountLoad(frame);
+
+        if (msg.msg_hdr.msg_flags & MSG_CONFIRM) {
+          // このソケットが送ったフレーム (receive_own の場合のみ届く)
+          tx_done_tx_.Fire(frame);
+          own++;
+          continue;
+        }
+
+        stats_.rx_frames++;
+        this->Deliver(frame);
+      }
+
+      received += result;
+      if (static_cast<std::size_t>(result) < Batch) {
+        break;
+      }
+    }
+
+    if (own != 0 && tx_count_ == 0) {
+      tx_empty_tx_.Fire(own);
+    }
+
+    return received;
+  }
+
+  /// @brief 受信するか (送信待ちがあれば) 送信できるようになるまで待ち，
+  ///  Receive() と Flush() を行う
+  /// @return 待っている間にエラーが起きた場合 false
+  auto Process(std::chrono::milliseconds timeout) -> bool {
+    pollfd poll_fd{fd_, POLLIN, 0};
+    if (tx_count_ != 0) {
+      poll_fd.events |= POLLOUT;
+    }
+
+    auto result = ::poll(&poll_fd, 1, static_cast<int>(timeout.count()));
+    if (result < 0) {
+      return errno == EINTR;
+    }
+    if (poll_fd.revents & (POLLERR | POLLNVAL)) {
+      return false;
+    }
+
+    if (poll_fd.revents & POLLIN) {
+      Receive();
+    }
+    if (tx_count_ != 0) {
+      Flush();
+    }
+
+    return true;
+  }
+
+  /// @brief 通知中のフレームの受信時刻 (CLOCK_REALTIME．分からなければ 0)
+  auto RxTimestamp() const -> std::chrono::nanoseconds { return rx_timestamp_; }
+
+  /// @brief RxTimestamp() がハードウェアの時刻か
+  auto IsHardwareTimestamp() const -> bool { return rx_hardware_timestamp_; }
+
+  /// @brief Flush() を待っている送信フレームの数
+  auto Pending() const -> std::size_t { return tx_count_; }
+
+  /// @brief 前回呼んでから見たフレームがバスを占有した時間の割合 (見積もり)
+  /// @details 同じホストで loopback を無効にした他のソケットの送信は見えないので数えない
+  auto BusLoad() -> float {
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - load_since_)
+            .count();
+    if (elapsed <= 0) {
+      return 0;
+    }
+
+    auto load = static_cast<float>(load_busy_ns_) / static_cast<float>(elapsed);
+    load_busy_ns_ = 0;
+    load_since_ = now;
+    return std::min(load, 1.0f);
+  }
+
+  auto Stats() const -> SocketCanStats const & { return stats_; }
+};
+
+using SocketCanBus = BasicSocketCanBus<types::CanFrame>;
+using SocketCanFdBus = BasicSocketCanBus<types::CanFdFrame>;
+}  // namespace robobus::can
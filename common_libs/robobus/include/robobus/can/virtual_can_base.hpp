@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <robotics/network/can_base.hpp>
+
+#include "virtual_can_bus.hpp"
+
+namespace robobus::can {
+/// @brief VirtualCanBus のノードを CANBase として使うためのもの
+/// @details 実機の SimpleCAN の代わりにホスト上のテストで使う．
+///  OnTx はフレームを送り終えた時，OnIdle はそれによって送信キューが
+///  空になった時に呼ばれる
+class VirtualCanBase : public robotics::network::CANBase {
+  using FrameCallback =
+      std::function<void(std::uint32_t, std::vector<std::uint8_t> const &)>;
+
+  std::shared_ptr<VirtualCanBus::Node> node_;
+
+  FrameCallback rx_;
+  FrameCallback tx_;
+  std::function<void()> idle_;
+
+  internal::SignalConnection<types::CanFrame> rx_connection_;
+  internal::SignalConnection<types::CanFrame> tx_connection_;
+
+  /// コールバックに渡すためのバッファ (使い回す)
+  std::vector<std::uint8_t> buffer_;
+
+ public:
+  explicit VirtualCanBase(std::shared_ptr<VirtualCanBus::Node> node)
+      : node_(std::move(node)) {
+    buffer_.reserve(types::CanFrame::kCapacity);
+
+    rx_connection_ = node_->rx.Connect([this](types::CanFrame const &frame) {
+      if (!rx_) {
+        return;
+      }
+
+      auto data = frame.Data();
+      buffer_.assign(data.begin(), data.end());
+      rx_(frame.id, buffer_);
+    });
+
+    tx_connection_ = node_->tx_done.Connect([this](types::CanFrame const &frame) {
+      if (tx_) {
+        auto data = frame.Data();
+        buffer_.assign(data.begin(), data.end());
+        tx_(frame.id, buffer_);
+      }
+
+      if (idle_ && node_->Pending() == 0) {
+        idle_();
+      }
+    });
+  }
+
+  ~VirtualCanBase() override {
+    rx_connection_.Disconnect();
+    tx_connection_.Disconnect();
+  }
+
+  VirtualCanBase(VirtualCanBase const &) = delete;
+  VirtualCanBase &operator=(VirtualCanBase const &) = delete;
+
+  void Init() override {}
+
+  /// @return 送信キューに積めた場合 1 (SimpleCAN と同じ)
+  int Send(uint32_t id, std::vector<uint8_t> const &data) override {
+    auto flags = types::InferFlagsFromId(id);
+    return node_->Send(types::CanFrame::Create(id, data, flags)) ? 1 : 0;
+  }
+
+  void OnRx(FrameCallback cb) override { rx_ = std::move(cb); }
+
+  void OnTx(FrameCallback cb) override { tx_ = std::move(cb); }
+
+  void OnIdle(std::function<void()> cb) override { idle_ = std::move(cb); }
+
+  float GetBusLoad() override { return node_->Bus().BusLoad(); }
+
+  auto Node() const -> VirtualCanBus::Node & { return *node_; }
+};
+}  // namespace robobus::can
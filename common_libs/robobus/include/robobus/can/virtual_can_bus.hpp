@@ -0,0 +1,383 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "can_bus.hpp"
+#include "can_frame_bits.hpp"
+
+namespace robobus::can {
+struct VirtualCanBusConfig {
+  /// 調停部分 (と Classic CAN 全体) のビットレート [bit/s]
+  std::uint32_t bitrate = 1000000;
+  /// CAN FD のデータ部分のビットレート [bit/s] (BRS 付きのフレームのみ)
+  std::uint32_t data_bitrate = 4000000;
+  /// 送信の試行ごとにエラーフレームが発生する確率 [ppm]
+  std::uint32_t error_ppm = 0;
+  /// 受信ノードごとにフレームを取りこぼす確率 [ppm] (受信バッファの溢れなど)
+  std::uint32_t loss_ppm = 0;
+  /// フレームを送り終えてから受信側の rx に通知されるまでの時間
+  /// (割り込みからアプリケーションが処理するまでの遅延)
+  std::chrono::nanoseconds rx_latency{0};
+  /// 各ノードの送信キューの大きさ (溢れた Send() は false を返す)
+  std::size_t tx_queue_depth = 32;
+  /// 乱数の種 (同じ種なら同じ結果になる)
+  std::uint32_t seed = 1;
+};
+
+struct VirtualCanNodeStats {
+  std::uint32_t tx_frames = 0;
+  std::uint32_t rx_frames = 0;
+  /// 送信キューが溢れて Send() が失敗した数
+  std::uint32_t tx_overflows = 0;
+  /// 取りこぼした受信フレームの数
+  std::uint32_t rx_lost = 0;
+  /// 送信中に起きたエラーの数 (自動で再送する)
+  std::uint32_t tx_errors = 0;
+};
+
+struct VirtualCanBusStats {
+  std::uint32_t frames = 0;
+  std::uint32_t error_frames = 0;
+  /// バスを占有していた時間の合計
+  std::chrono::nanoseconds busy{0};
+};
+
+/// @brief 複数のノードが繋がった仮想 CAN バス
+/// @details ノードが Send() したフレームはノードごとの送信キューに入り，
+///  バスが空くと各キューの先頭で ID による調停を行う (ID の小さい方が勝つ．
+///  同じ基本 ID では標準 ID が拡張 ID に勝つ)．フレームはビットレートと
+///  ビットスタッフィングから求めた時間だけバスを占有し，送り終えてから
+///  rx_latency 後に送信元以外の全ノードに届く．error_ppm の確率で送信中にエラーフレームが
+///  発生し，そのフレームは再び調停に参加する．
+///  時間は AdvanceTo() で進める (Loop<VirtualClock> と組み合わせることを想定)
+/// @tparam Frame types::CanFrame もしくは types::CanFdFrame
+template <typename Frame>
+class BasicVirtualCanBus {
+ public:
+  using Duration = std::chrono::nanoseconds;
+
+  /// @brief バスに繋がったノード
+  class Node : public BasicCanBus<Frame> {
+    friend class BasicVirtualCanBus;
+
+    BasicVirtualCanBus *bus_;
+    /// 送信キュー (固定長のリングバッファ)
+    std::vector<Frame> queue_;
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+    VirtualCanNodeStats stats_;
+
+    internal::SignalTx<Frame> tx_done_tx_{
+        std::make_shared<internal::Signal<Frame>>()};
+
+    auto Head() const -> Frame const & { return queue_[head_]; }
+
+    void Pop() {
+      head_ = (head_ + 1) % queue_.size();
+      count_--;
+    }
+
+   public:
+    /// @brief フレームを送り終えた (ACK を受け取った)
+    internal::SignalRx<Frame> tx_done{tx_done_tx_};
+
+    Node(BasicVirtualCanBus &bus, std::size_t depth)
+        : bus_(&bus), queue_(depth) {}
+
+    auto Send(Frame const &frame) -> bool override {
+      if (count_ == queue_.size()) {
+        stats_.tx_overflows++;
+        return false;
+      }
+
+      queue_[(head_ + count_) % queue_.size()] = frame;
+      count_++;
+      return true;
+    }
+
+    /// @brief 送信キューに残っているフレームの数
+    auto Pending() const -> std::size_t { return count_; }
+
+    auto Stats() const -> VirtualCanNodeStats const & { return stats_; }
+
+    auto Bus() const -> BasicVirtualCanBus & { return *bus_; }
+  };
+
+ private:
+  VirtualCanBusConfig config_;
+  std::vector<std::weak_ptr<Node>> nodes_;
+  std::uint32_t random_;
+
+  Duration now_{0};
+  /// 送信中のフレームの送信元 (送信中でなければ std::nullopt)
+  std::optional<std::size_t> current_;
+  /// 送信中のフレームが失敗するか
+  bool current_error_ = false;
+  /// バスが次に空く時刻
+  Duration free_at_{0};
+
+  struct Delivery {
+    Duration at;
+    std::size_t from;
+    Frame frame;
+  };
+
+  /// rx_latency の後に配るフレーム (rx_latency は一定なので時刻順に並ぶ)
+  std::deque<Delivery> deliveries_;
+
+  VirtualCanBusStats stats_;
+
+  auto Random() -> std::uint32_t {
+    // xorshift32
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 17;
+    random_ ^= random_ << 5;
+    return random_;
+  }
+
+  auto Chance(std::uint32_t ppm) -> bool {
+    return ppm != 0 && Random() % 1000000 < ppm;
+  }
+
+  auto BitTime(std::uint32_t bits, std::uint32_t bitrate) const -> Duration {
+    return Duration(static_cast<std::int64_t>(bits) * 1000000000 / bitrate);
+  }
+
+  auto FrameTime(Frame const &frame) const -> Duration {
+    auto bits = CanFrameBits::Of(frame);
+    return BitTime(bits.nominal, config_.bitrate) +
+           BitTime(bits.data, config_.data_bitrate);
+  }
+
+  /// @brief 調停の優先度 (小さいほど強い)
+  static auto Priority(Frame const &frame) -> std::uint32_t {
+    auto remote =
+        types::HasFlag(frame.flags, types::CanFrameFlags::kRemote) ? 1u : 0u;
+    if (frame.IsExtended()) {
+      // 基本 ID の後に SRR=1, IDE=1 が続くので同じ基本 ID の標準 ID に負ける
+      return (frame.id >> 18 & 0x7FF) << 21 | 3u << 19 |
+             (frame.id & 0x3FFFF) << 1 | remote;
+    }
+
+    return (frame.id & 0x7FF) << 21 | remote << 20;
+  }
+
+  auto Arbitrate() -> std::optional<std::size_t> {
+    std::optional<std::size_t> winner;
+    std::uint32_t best = 0;
+
+    for (std::size_t i = 0; i < nodes_.size(); i++) {
+      auto node = nodes_[i].lock();
+      if (!node || node->count_ == 0) {
+        continue;
+      }
+
+      auto priority = Priority(node->Head());
+      if (!winner || priority < best) {
+        winner = i;
+        best = priority;
+      }
+    }
+
+    return winner;
+  }
+
+  void Start(std::size_t index, Duration start) {
+    auto node = nodes_[index].lock();
+    auto duration = FrameTime(node->Head());
+
+    current_ = index;
+    current_error_ = Chance(config_.error_ppm);
+    if (current_error_) {
+      // フレームの途中でエラーを検出し，エラーフラグ (6) + 重なり (6) +
+      // デリミタ (8) + IFS (3) を送る
+      auto bits = static_cast<std::uint32_t>(
+          duration.count() * config_.bitrate / 1000000000);
+      auto at = bits == 0 ? 0 : Random() % bits;
+      duration = BitTime(at + 23, config_.bitrate);
+    }
+
+    free_at_ = start + duration;
+    stats_.busy += duration;
+  }
+
+  void Finish() {
+    auto index = *current_;
+    current_.reset();
+    now_ = free_at_;
+
+    auto sender = nodes_[index].lock();
+    if (!sender) {
+      return;
+    }
+
+    if (current_error_) {
+      stats_.error_frames++;
+      sender->stats_.tx_errors++;
+      return;
+    }
+
+    // 受信側が Send() してもキューの先頭が変わらないよう，先に取り出す
+    auto frame = sender->Head();
+    sender->Pop();
+    sender->stats_.tx_frames++;
+    stats_.frames++;
+
+    sender->tx_done_tx_.Fire(frame);
+
+    if (config_.rx_latency.count() == 0) {
+      Deliver(index, frame);
+    } else {
+      deliveries_.push_back({now_ + config_.rx_latency, index, frame});
+    }
+  }
+
+  void DeliverNext() {
+    auto delivery = deliveries_.front();
+    deliveries_.pop_front();
+    if (now_ < delivery.at) {
+      now_ = delivery.at;
+    }
+
+    Deliver(delivery.from, delivery.frame);
+  }
+
+  /// @brief 送信元以外の全ノードにフレームを配る
+  void Deliver(std::size_t from, Frame const &frame) {
+    for (std::size_t i = 0; i < nodes_.size(); i++) {
+      if (i == from) {
+        continue;
+      }
+
+      auto node = nodes_[i].lock();
+      if (!node) {
+        continue;
+      }
+
+      if (Chance(config_.loss_ppm)) {
+        node->stats_.rx_lost++;
+        continue;
+      }
+
+      node->stats_.rx_frames++;
+      node->Deliver(frame);
+    }
+  }
+
+ public:
+  explicit BasicVirtualCanBus(VirtualCanBusConfig config = {})
+      : config_(config), random_(config.seed == 0 ? 1 : config.seed) {}
+
+  BasicVirtualCanBus(BasicVirtualCanBus const &) = delete;
+  BasicVirtualCanBus &operator=(BasicVirtualCanBus const &) = delete;
+
+  /// @brief ノードを繋ぐ (返り値を破棄するとバスから外れる)
+  auto Attach() -> std::shared_ptr<Node> {
+    auto node = std::make_shared<Node>(*this, config_.tx_queue_depth);
+    nodes_.push_back(node);
+    return node;
+  }
+
+  /// @brief time までバスを進め，その間に送り終えたフレームを配る
+  void AdvanceTo(Duration time) {
+    while (true) {
+      // 送信の開始・完了と受信の通知を時刻順に処理する
+      std::optional<Duration> delivery;
+      if (!deliveries_.empty() && deliveries_.front().at <= time) {
+        delivery = deliveries_.front().at;
+      }
+
+      if (current_) {
+        if (delivery && *delivery <= free_at_) {
+          DeliverNext();
+          continue;
+        }
+
+        if (time < free_at_) {
+          break;
+        }
+
+        Finish();
+        continue;
+      }
+
+      auto start = now_ < free_at_ ? free_at_ : now_;
+      if (start <= time && (!delivery || start <= *delivery)) {
+        if (auto winner = Arbitrate(); winner) {
+          Start(*winner, start);
+          continue;
+        }
+      }
+
+      if (delivery) {
+        DeliverNext();
+        continue;
+      }
+
+      break;
+    }
+
+    if (now_ < time) {
+      now_ = time;
+    }
+  }
+
+  void AdvanceBy(Duration delta) { AdvanceTo(now_ + delta); }
+
+  /// @brief 送信中・送信待ち・通知待ちのフレームがあるか
+  auto Busy() const -> bool {
+    if (current_ || !deliveries_.empty()) {
+      return true;
+    }
+
+    for (auto const &weak : nodes_) {
+      if (auto node = weak.lock(); node && node->count_ != 0) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /// @brief 次にフレームの送信が終わるか受信が通知される時刻
+  ///  (どちらも無ければ std::nullopt)
+  auto NextEvent() const -> std::optional<Duration> {
+    std::optional<Duration> next;
+    if (current_) {
+      next = free_at_;
+    }
+    if (!deliveries_.empty() && (!next || deliveries_.front().at < *next)) {
+      next = deliveries_.front().at;
+    }
+    return next;
+  }
+
+  auto Now() const -> Duration { return now_; }
+
+  auto Stats() const -> VirtualCanBusStats const & { return stats_; }
+
+  /// @brief 0 から現在までのバスの占有率
+  auto BusLoad() const -> float {
+    if (now_.count() == 0) {
+      return 0;
+    }
+    return static_cast<float>(stats_.busy.count()) /
+           static_cast<float>(now_.count());
+  }
+
+  /// @brief フレーム 1 つがバスを占有する時間
+  auto FrameDuration(Frame const &frame) const -> Duration {
+    return FrameTime(frame);
+  }
+};
+
+using VirtualCanBus = BasicVirtualCanBus<types::CanFrame>;
+using VirtualCanFdBus = BasicVirtualCanBus<types::CanFdFrame>;
+}  // namespace robobus::can
@@ -1,112 +1,128 @@
 #pragma once
 
-#include <optional>
-#include <cstring>
+#include <string_view>
+#include <type_traits>
 
 #include <logger/logger.hpp>
 
 #include "root_context.hpp"
 #include "../debug/debug_info.hpp"
+#include "../runtime/signal_awaiter.hpp"
 #include "../runtime/sleep.hpp"
+#include "../runtime/ticker.hpp"
+#include "../runtime/timeout.hpp"
 
 namespace robobus::context {
+/// @brief Context を参照するためのハンドル
+/// @details RootContext へのポインタと ContextTable の番号だけを持つ
+///  trivially copyable な値なので，コルーチンの引数などとして自由に複製してよい．
+///  参照カウントを持たないため，RootContext より長く使ってはならない
 template <typename Clock>
   requires std::chrono::is_clock_v<Clock>
-class SharedContext;
-
-/// @brief コルーチンベースプログラムで用いるコンテキスト
-template <typename Clock>
-  requires std::chrono::is_clock_v<Clock>
-struct Context {
- private:
-  std::string tag_;
-  std::string path_;
-
-  std::vector<SharedContext<Clock>> child_contexts_;
-
-  std::weak_ptr<RootContext<Clock>> root_ctx;
-
-  std::vector<debug::DebugInfo<Clock>> debug_infos_;
-  std::optional<robotics::logger::Logger> logger;
+class ContextHandle {
+  RootContext<Clock>* root_;
+  ContextID id_;
 
  public:
-  explicit Context(std::weak_ptr<RootContext<Clock>> root, std::string_view tag,
-                   std::string_view parent_path)
-      : root_ctx(root),
-        tag_(tag),
-        path_(std::string(parent_path) + "." + std::string(tag)) {}
+  ContextHandle(RootContext<Clock>& root, ContextID id)
+      : root_(&root), id_(id) {}
 
-  explicit Context(std::weak_ptr<RootContext<Clock>> root, std::string_view tag)
-      : root_ctx(root), tag_(tag), path_(tag) {}
+  auto Root() const -> RootContext<Clock>& { return *root_; }
 
-  auto Root() -> std::weak_ptr<RootContext<Clock>> { return root_ctx; }
-
-  auto AddChild(SharedContext<Clock> sub_context) {
-    child_contexts_.emplace_back(sub_context);
-  }
+  auto GetLoop() const -> runtime::Loop<Clock>& { return root_->GetLoop(); }
 
-  auto ContextId() -> std::string { return path_; }
+  /// @brief ContextTable 上の番号
+  auto Id() const -> ContextID { return id_; }
 
-  inline auto AddTask(std::coroutine_handle<> coroutine) -> void {
-    Root().loop.AddTask(coroutine);
+  /// @brief ルートからのパス (`<親のパス>.<tag>`)
+  auto ContextId() const -> std::string_view {
+    return root_->Contexts().Get(id_).path;
   }
 
-  auto AddDebugInfo(debug::DebugInfo<Clock> debug_info) {
-    debug_infos_.emplace_back(debug_info);
+  /// @brief ContextId() と同じ文字列 (RootContext が生きている間有効)
+  auto Path() const -> const char* {
+    return root_->Contexts().Get(id_).path.c_str();
   }
 
-  auto Logger() -> robotics::logger::Logger& {
-    if (!logger.has_value()) {
-      auto cid = ContextId();
-
-      auto cid_cstr = new char[cid.size() + 1];
-      std::strcpy(cid_cstr, cid.c_str());
-
-      logger = robotics::logger::Logger(tag_.c_str(), cid_cstr);
-    }
-
-    return logger.value();
+  auto Child(std::string_view tag) const -> ContextHandle<Clock> {
+    return ContextHandle<Clock>(*root_, root_->Intern(id_, tag));
   }
-};
 
-template <typename Clock>
-  requires std::chrono::is_clock_v<Clock>
-class SharedContext {
-  std::shared_ptr<Context<Clock>> ctx;
+  auto Sleep(std::chrono::milliseconds duration) {
+    return runtime::Sleep(GetLoop(), duration);
+  }
 
- public:
-  SharedContext(std::weak_ptr<RootContext<Clock>> root, std::string_view tag)
-      : ctx(std::make_shared<Context<Clock>>(root, tag)) {}
+  /// @brief 取り消し可能な Sleep
+  /// @return 最後まで Sleep した場合 true (取り消された場合 false)
+  auto Sleep(std::chrono::milliseconds duration,
+             runtime::CancellationToken token) {
+    return runtime::Sleep(GetLoop(), duration, token);
+  }
 
-  SharedContext(std::weak_ptr<RootContext<Clock>> root, std::string_view tag,
-                std::string_view parent_path)
-      : ctx(std::make_shared<Context<Clock>>(root, tag, parent_path)) {}
+  /// @brief タスクを期限付きで待つ
+  /// @return タスクの結果 (期限切れの場合 std::nullopt)
+  template <typename T>
+  auto WithTimeout(coroutine::Task<T> task, std::chrono::milliseconds timeout) {
+    return runtime::WithTimeout(GetLoop(), std::move(task), timeout);
+  }
 
-  auto Root() -> std::weak_ptr<RootContext<Clock>> { return ctx->Root(); }
+  /// @brief 周期実行のためのタイマーを作る
+  /// @details `auto tick = ctx.Every(1ms); while (true) { co_await tick; ... }`
+  auto Every(std::chrono::milliseconds period,
+             runtime::TickPolicy policy = runtime::TickPolicy::kCatchUp) {
+    return runtime::Every(GetLoop(), period, policy);
+  }
 
-  auto GetLoop() -> runtime::Loop<Clock>& { return Root().lock()->GetLoop(); }
+  /// @brief Signal の次の Fire を待つ
+  template <typename T>
+  auto Next(internal::SignalRx<T> rx) {
+    return runtime::Next(GetLoop(), rx);
+  }
 
-  auto ContextId() -> std::string { return ctx->ContextId(); }
+  /// @brief Signal の次の Fire をタイムアウト付きで待つ
+  /// @return Fire されたデータ (タイムアウトした場合 std::nullopt)
+  template <typename T>
+  auto Next(internal::SignalRx<T> rx, std::chrono::milliseconds timeout) {
+    return runtime::Next(GetLoop(), rx, timeout);
+  }
 
-  auto Child(std::string tag) -> SharedContext<Clock> {
-    auto child = SharedContext<Clock>(Root(), tag, ContextId());
-    ctx->AddChild(child);
+  auto Logger() -> robotics::logger::Logger& { return root_->Logger(id_); }
 
-    return child;
+  /// @brief `<ContextId>.<tag>` を番号として登録し，それを送り先とする DebugInfo を作る
+  auto GetDebugInfo(std::string_view tag) -> debug::DebugInfo<Clock> {
+    return debug::DebugInfo<Clock>(*root_, root_->Intern(id_, tag));
   }
 
-  auto Sleep(std::chrono::milliseconds duration) {
-    return runtime::Sleep(GetLoop(), duration);
+  template <runtime::TaskPromise Promise>
+  inline auto AddTask(std::coroutine_handle<Promise> coroutine) -> void {
+    coroutine.promise().SetOwner(id_);
+    root_->AddTask(coroutine);
   }
 
-  auto Logger() -> robotics::logger::Logger& { return ctx->Logger(); }
-
-  auto GetDebugInfo(std::string const& tag) -> debug::DebugInfo<Clock> {
-    return debug::DebugInfo<Clock>(*this, ContextId() + "." + tag);
+  /// @brief 優先度クラスを指定してタスクを追加する
+  /// @details 最初の中断点までの実行には priority が効かない (runtime::Loop::Start())
+  template <runtime::TaskPromise Promise>
+  inline auto AddTask(std::coroutine_handle<Promise> coroutine,
+                      runtime::Priority priority) -> void {
+    coroutine.promise().SetPriority(priority);
+    AddTask(coroutine);
   }
 
-  inline auto AddTask(std::coroutine_handle<> coroutine) -> void {
-    Root().lock()->AddTask(coroutine);
+  /// @brief 優先度クラスを指定してコルーチンを作り，タスクとして追加する
+  /// @details start() の最初の実行から priority と所属 (この Context) が効く
+  template <typename F>
+  inline auto Start(runtime::Priority priority, F &&start) -> void {
+    runtime::PriorityScope priority_scope(priority);
+    runtime::OwnerScope owner_scope(id_);
+    AddTask(start().handle);
   }
 };
+
+static_assert(std::is_trivially_copyable_v<
+              ContextHandle<std::chrono::steady_clock>>);
+
+/// @brief 互換のための別名 (以前は shared_ptr で Context を共有していた)
+template <typename Clock>
+  requires std::chrono::is_clock_v<Clock>
+using SharedContext = ContextHandle<Clock>;
 }  // namespace robobus::context
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+namespace robobus::context {
+/// @brief Context (と DebugInfo のキー) を表す番号
+/// @details パスの文字列は RootContext の ContextTable に一度だけ登録され，
+///  デバッグ出力などではこの番号だけを送る
+using ContextID = std::uint16_t;
+
+/// @brief どの Context にも属さないことを表す番号 (ルートの子の親など)
+constexpr ContextID kNoContext = 0xFFFF;
+}  // namespace robobus::context
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+
+#include <deque>
+#include <string>
+#include <string_view>
+
+#include "context_id.hpp"
+
+namespace robobus::context {
+/// @brief Context のパスを一度だけ組み立てて保持する文字列表
+/// @details 要素は std::deque に置くため，登録後に返した文字列の
+///  ポインタは ContextTable が生きている間ずっと有効
+class ContextTable {
+ public:
+  struct Entry {
+    ContextID parent;
+    std::string tag;
+    /// ルートからのパス (`<親のパス>.<tag>`)
+    std::string path;
+  };
+
+  struct InternResult {
+    ContextID id;
+    /// 新しく登録した場合 true
+    bool added;
+  };
+
+  /// @brief 登録できる数 (番号 kNoContext は使わない)
+  static constexpr std::size_t kCapacity = kNoContext;
+
+ private:
+  std::deque<Entry> entries_;
+
+ public:
+  /// @brief (parent, tag) を登録する
+  /// @details 同じ (parent, tag) が既にあればその番号を返す．
+  ///  登録は初期化時にしか起きないので線形探索で十分
+  /// @return 表が一杯 (kCapacity 個) の場合 id は kNoContext
+  auto Intern(ContextID parent, std::string_view tag) -> InternResult {
+    for (std::size_t i = 0; i < entries_.size(); i++) {
+      auto const &entry = entries_[i];
+      if (entry.parent == parent && entry.tag == tag) {
+        return {static_cast<ContextID>(i), false};
+      }
+    }
+
+    if (kCapacity <= entries_.size()) {
+      return {kNoContext, false};
+    }
+
+    auto path = parent == kNoContext
+                    ? std::string(tag)
+                    : entries_[parent].path + "." + std::string(tag);
+
+    auto id = static_cast<ContextID>(entries_.size());
+    entries_.push_back(Entry{parent, std::string(tag), std::move(path)});
+
+    return {id, true};
+  }
+
+  auto Get(ContextID id) const -> Entry const & { return entries_[id]; }
+
+  auto Size() const -> std::size_t { return entries_.size(); }
+
+  template <typename F>
+  void ForEach(F &&f) const {
+    for (std::size_t i = 0; i < entries_.size(); i++) {
+      f(static_cast<ContextID>(i), entries_[i]);
+    }
+  }
+};
+}  // namespace robobus::context
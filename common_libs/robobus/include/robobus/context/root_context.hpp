@@ -1,24 +1,37 @@
 #pragma once
 
+#include <deque>
 #include <memory>
+#include <optional>
+
+#include <logger/logger.hpp>
+#include <robotics/platform/panic.hpp>
 
 #include "../debug/debug_adapter.hpp"
+#include "context_table.hpp"
 #include "../runtime/loop.hpp"
 
 namespace robobus::context {
 template <typename Clock>
   requires std::chrono::is_clock_v<Clock>
-class SharedContext;
+class ContextHandle;
 
 /// @brief コルーチンベースプログラムで用いるコンテキスト
+/// @details 子の Context はすべて ContextTable の番号で管理し，
+///  ContextHandle (RootContext へのポインタと番号の組) から参照する
 template <typename Clock>
   requires std::chrono::is_clock_v<Clock>
 struct RootContext {
  private:
-  std::vector<SharedContext<Clock>> child_contexts_;
   runtime::Loop<Clock> loop_{};
 
   std::optional<std::shared_ptr<debug::DebugAdapter>> debug_adapter_;
+  /// DebugInfo から参照カウントを触らずに使うためのポインタ
+  debug::DebugAdapter* debug_adapter_ptr_ = nullptr;
+
+  ContextTable contexts_;
+  /// 番号ごとの Logger (初めて使われた時に作る)
+  std::deque<std::optional<robotics::logger::Logger>> loggers_;
 
  public:
   [[noreturn]]
@@ -28,8 +41,14 @@ struct RootContext {
 
   auto GetLoop() -> runtime::Loop<Clock>& { return loop_; }
 
+  /// @details 既に登録されている Context はこの時点でまとめて登録する
   auto SetDebugAdapter(std::shared_ptr<debug::DebugAdapter> adapter) -> void {
     debug_adapter_ = adapter;
+    debug_adapter_ptr_ = adapter.get();
+
+    contexts_.ForEach([&adapter](ContextID id, ContextTable::Entry const& entry) {
+      adapter->RegisterContext(id, entry.parent, entry.tag);
+    });
   }
 
   auto GetDebugAdapter()
@@ -37,11 +56,45 @@ struct RootContext {
     return debug_adapter_;
   }
 
-  auto AddChild(SharedContext<Clock> sub_context) -> void {
-    child_contexts_.emplace_back(sub_context);
+  /// @brief 設定されている DebugAdapter (無い場合 nullptr)
+  auto DebugAdapterPtr() const -> debug::DebugAdapter* {
+    return debug_adapter_ptr_;
+  }
+
+  /// @brief (parent, tag) のパスを登録し，その番号を返す
+  /// @details 新しく登録した場合は DebugAdapter にも知らせる．
+  ///  ContextTable が一杯の場合は panic する
+  auto Intern(ContextID parent, std::string_view tag) -> ContextID {
+    auto [id, added] = contexts_.Intern(parent, tag);
+    if (id == kNoContext) {
+      robotics::system::panic("RootContext: context table is full");
+    }
+    if (added && debug_adapter_.has_value()) {
+      debug_adapter_.value()->RegisterContext(id, parent, tag);
+    }
+
+    return id;
+  }
+
+  auto Contexts() const -> ContextTable const& { return contexts_; }
+
+  /// @brief 番号 id の Context の Logger
+  auto Logger(ContextID id) -> robotics::logger::Logger& {
+    if (loggers_.size() <= id) {
+      loggers_.resize(id + 1);
+    }
+
+    auto& logger = loggers_[id];
+    if (!logger.has_value()) {
+      auto const& entry = contexts_.Get(id);
+      logger.emplace(entry.tag.c_str(), entry.path.c_str());
+    }
+
+    return logger.value();
   }
 
-  inline auto AddTask(std::coroutine_handle<> coroutine) -> void {
+  template <runtime::TaskPromise Promise>
+  inline auto AddTask(std::coroutine_handle<Promise> coroutine) -> void {
     loop_.AddTask(coroutine);
   }
 };
@@ -69,16 +122,15 @@ class SharedRootContext {
 
   auto GetDebugAdapter()
       -> std::optional<std::shared_ptr<debug::DebugAdapter>> {
-    return root->DebugAdapter();
+    return root->GetDebugAdapter();
   }
 
-  auto Child(std::string tag) -> SharedContext<Clock> {
-    auto ctx = SharedContext<Clock>(root, tag);
-    root->AddChild(ctx);
-    return ctx;
+  auto Child(std::string_view tag) -> ContextHandle<Clock> {
+    return ContextHandle<Clock>(*root, root->Intern(kNoContext, tag));
   }
 
-  inline auto AddTask(std::coroutine_handle<> coroutine) -> void {
+  template <runtime::TaskPromise Promise>
+  inline auto AddTask(std::coroutine_handle<Promise> coroutine) -> void {
     root->AddTask(coroutine);
   }
 };
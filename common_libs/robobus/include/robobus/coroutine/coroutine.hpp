@@ -2,6 +2,7 @@
 
 #include <coroutine>
 #include "promise.hpp"
+#include "coroutine_awaiter.hpp"
 
 namespace robobus::coroutine {
 template <typename ReturnType>
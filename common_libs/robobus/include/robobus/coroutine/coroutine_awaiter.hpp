@@ -17,7 +17,8 @@ struct CoroutineAwaiter<ReturnType> {
 
   bool await_ready() const { return (bool)promise.get_return_value(); }
   void await_suspend(std::coroutine_handle<> handle) {
-    promise.AddOnReturnCallback([handle]() { handle.resume(); });
+    waiter.SetHandle(handle);
+    promise.AddReturnWaiter(waiter);
   }
   auto await_resume() const {
     if (promise.get_return_value()) {
@@ -29,6 +30,7 @@ struct CoroutineAwaiter<ReturnType> {
 
  private:
   Promise<ReturnType> &promise;
+  ReturnWaiter waiter;
 };
 
 template <>
@@ -37,11 +39,13 @@ struct CoroutineAwaiter<void> {
 
   bool await_ready() const { return promise.get_return_value(); }
   void await_suspend(std::coroutine_handle<> handle) {
-    promise.AddOnReturnCallback([handle]() { handle.resume(); });
+    waiter.SetHandle(handle);
+    promise.AddReturnWaiter(waiter);
   }
   auto await_resume() const { return; }
 
  private:
   Promise<void> &promise;
+  ReturnWaiter waiter;
 };
 }  // namespace robobus::coroutine
\ No newline at end of file
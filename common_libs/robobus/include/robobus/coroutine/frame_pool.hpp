@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <new>
+
+#if defined(__MBED__)
+#include <platform/mbed_critical.h>
+#else
+#include <atomic>
+#include <thread>
+#endif
+
+/// @def ROBOBUS_FRAME_POOL_BLOCK_SIZE
+/// @brief コルーチンフレーム用プールの 1 ブロックの大きさ [byte]
+#ifndef ROBOBUS_FRAME_POOL_BLOCK_SIZE
+#define ROBOBUS_FRAME_POOL_BLOCK_SIZE 256
+#endif
+
+/// @def ROBOBUS_FRAME_POOL_BLOCKS
+/// @brief コルーチンフレーム用プールのブロック数
+#ifndef ROBOBUS_FRAME_POOL_BLOCKS
+#define ROBOBUS_FRAME_POOL_BLOCKS 32
+#endif
+
+/// @def ROBOBUS_FRAME_POOL_STRICT
+/// @brief 定義すると，ブロックに収まらないフレームをヒープに逃がさず panic する
+/// @details 加えて，最適化 (-O1 以上) でフレームの大きさが定数に畳み込まれた場合は
+///  ビルド時にも検出する (GCC ではコンパイルエラー，それ以外ではリンクエラー)．
+///  ビルド時の検出は最適化に依存するので保証ではなく，-O0 では実行時の panic のみ
+
+#if defined(ROBOBUS_FRAME_POOL_STRICT)
+#include <robotics/platform/panic.hpp>
+
+#if defined(__GNUC__) && !defined(__clang__)
+extern "C" [[gnu::error(
+    "coroutine frame exceeds ROBOBUS_FRAME_POOL_BLOCK_SIZE")]] void
+robobus_coroutine_frame_exceeds_pool_block();
+#else
+extern "C" void robobus_coroutine_frame_exceeds_pool_block();
+#endif
+#endif
+
+namespace robobus::coroutine {
+/// @brief コルーチンフレームを確保する固定長ブロックプール
+/// @details 静的領域に確保したブロックを空きリストで管理する．
+///  ブロックに収まらない場合やプールが枯渇した場合はヒープから確保する．
+///  空きリストの操作は短いクリティカルセクションで守る．Mbed では割り込みを
+///  禁止するので，どのスレッドや割り込みからコルーチンを作成・破棄してもよく，
+///  優先度の低いスレッドがロックを持ったまま止まることもない．
+///  ホストでは (Executor のワーカーのような) スレッド間でのみ共有できる
+class FramePool {
+ public:
+  static constexpr std::size_t kBlockSize = ROBOBUS_FRAME_POOL_BLOCK_SIZE;
+  static constexpr std::size_t kBlocks = ROBOBUS_FRAME_POOL_BLOCKS;
+
+  struct Stats {
+    /// 使用中のブロック数
+    std::size_t in_use;
+    /// 使用中のブロック数の最大値
+    std::size_t high_water;
+    /// ヒープから確保した回数 (ブロックに収まらなかった / 枯渇した)
+    std::size_t fallbacks;
+    /// 要求されたフレームの最大の大きさ [byte]
+    std::size_t largest_frame;
+  };
+
+ private:
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  static_assert(kBlockSize >= sizeof(FreeBlock));
+  static_assert(kBlockSize % alignof(std::max_align_t) == 0,
+                "ROBOBUS_FRAME_POOL_BLOCK_SIZE must keep blocks aligned");
+
+  alignas(std::max_align_t) static inline std::byte
+      storage_[kBlockSize * kBlocks];
+
+  static inline FreeBlock *free_list_ = nullptr;
+  /// まだ一度も使われていないブロックの先頭番号
+  static inline std::size_t untouched_ = 0;
+
+  static inline Stats stats_{};
+
+#if defined(__MBED__)
+  /// @brief 割り込みを禁止する (入れ子にできる)
+  struct Lock {
+    Lock() { core_util_critical_section_enter(); }
+    ~Lock() { core_util_critical_section_exit(); }
+  };
+#else
+  static inline std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+
+  struct Lock {
+    Lock() {
+      while (lock_.test_and_set(std::memory_order_acquire)) {
+        // 持っているスレッドが横取りされていれば先に進ませる
+        std::this_thread::yield();
+      }
+    }
+    ~Lock() { lock_.clear(std::memory_order_release); }
+  };
+#endif
+
+  static auto Owns(void *ptr) -> bool {
+    auto p = static_cast<std::byte *>(ptr);
+    return storage_ <= p && p < storage_ + sizeof(storage_);
+  }
+
+  static auto TakeBlock() -> void * {
+    if (free_list_ != nullptr) {
+      auto block = free_list_;
+      free_list_ = block->next;
+      return block;
+    }
+
+    if (untouched_ < kBlocks) {
+      return storage_ + kBlockSize * untouched_++;
+    }
+
+    return nullptr;
+  }
+
+ public:
+  [[gnu::always_inline]] static inline auto Allocate(std::size_t size)
+      -> void * {
+#if defined(ROBOBUS_FRAME_POOL_STRICT)
+    if (__builtin_constant_p(size) && size > kBlockSize) {
+      robobus_coroutine_frame_exceeds_pool_block();
+    }
+#endif
+
+    return AllocateBlock(size);
+  }
+
+  static auto AllocateBlock(std::size_t size) -> void * {
+#if defined(ROBOBUS_FRAME_POOL_STRICT)
+    if (size > kBlockSize) {
+      robotics::system::panic(
+          "FramePool: coroutine frame exceeds ROBOBUS_FRAME_POOL_BLOCK_SIZE");
+    }
+#endif
+
+    {
+      Lock lock;
+
+      if (stats_.largest_frame < size) {
+        stats_.largest_frame = size;
+      }
+
+      if (size <= kBlockSize) {
+        if (auto block = TakeBlock()) {
+          stats_.in_use++;
+          if (stats_.high_water < stats_.in_use) {
+            stats_.high_water = stats_.in_use;
+          }
+
+          return block;
+        }
+      }
+
+      stats_.fallbacks++;
+    }
+
+    return ::operator new(size);
+  }
+
+  static void Deallocate(void *ptr) {
+    if (!Owns(ptr)) {
+      ::operator delete(ptr);
+      return;
+    }
+
+    Lock lock;
+    auto block = static_cast<FreeBlock *>(ptr);
+    block->next = free_list_;
+    free_list_ = block;
+    stats_.in_use--;
+  }
+
+  static auto GetStats() -> Stats {
+    Lock lock;
+    return stats_;
+  }
+};
+}  // namespace robobus::coroutine
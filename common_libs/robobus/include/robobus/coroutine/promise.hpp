@@ -1,10 +1,15 @@
 #pragma once
 
+#include <cstddef>
+
 #include <coroutine>
+#include <exception>
 #include <optional>
 #include <type_traits>
-#include <vector>
-#include <functional>
+
+#include "../../internal/intrusive_list.hpp"
+#include "../runtime/task_node.hpp"
+#include "frame_pool.hpp"
 
 namespace robobus::coroutine {
 //* Forward declaration
@@ -14,29 +19,52 @@ struct Coroutine;
 template <typename ReturnType>
 struct Promise;
 
+struct ReturnWaiterTag;
+
+/// @brief コルーチンの終了を待っている側の情報
+/// @details 待つ側の awaiter に埋め込まれるため，登録時にメモリ確保は発生しない
+class ReturnWaiter : public internal::IntrusiveListHook<ReturnWaiterTag> {
+  std::coroutine_handle<> handle_;
+
+ public:
+  void SetHandle(std::coroutine_handle<> handle) { handle_ = handle; }
+
+  void Resume() const { handle_.resume(); }
+};
+
 //* BasePromise
 template <typename ReturnType>
-class BasePromise {
+class BasePromise : public runtime::TaskNode {
  protected:
-  void Return() const {
-    for (auto &callback : on_return_callbacks) {
-      callback();
+  void Return() {
+    while (auto waiter = waiters_.PopFront()) {
+      waiter->Resume();
     }
   }
 
  public:
-  void AddOnReturnCallback(std::function<void()> callback) {
-    on_return_callbacks.emplace_back(callback);
+  /// @brief フレームは FramePool から確保する
+  [[gnu::always_inline]] static void *operator new(std::size_t size) {
+    return FramePool::Allocate(size);
   }
 
+  static void operator delete(void *ptr) { FramePool::Deallocate(ptr); }
+
+  /// @brief コルーチンの終了時に waiter を再開する
+  void AddReturnWaiter(ReturnWaiter &waiter) { waiters_.PushBack(waiter); }
+
   operator Promise<ReturnType> &() {
     return *static_cast<Promise<ReturnType> *>(this);
   }
 
  public:
   auto get_return_object() {
-    return Coroutine<ReturnType>{
-        std::coroutine_handle<Promise<ReturnType>>::from_promise(*this)};
+    using Handle = std::coroutine_handle<Promise<ReturnType>>;
+
+    auto handle = Handle::from_promise(*this);
+    this->SetHandle(handle);
+
+    return Coroutine<ReturnType>{handle};
   }
 
   auto initial_suspend() { return std::suspend_never{}; }
@@ -46,7 +74,7 @@ class BasePromise {
   auto unhandled_exception() { std::terminate(); }
 
  private:
-  std::vector<std::function<void()>> on_return_callbacks;
+  internal::IntrusiveList<ReturnWaiter, ReturnWaiterTag> waiters_;
 };
 
 //* Promise
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "../runtime/task_node.hpp"
+#include "frame_pool.hpp"
+
+namespace robobus::coroutine {
+//* Forward declaration
+template <typename ReturnType>
+class Task;
+
+template <typename ReturnType>
+class LazyPromise;
+
+//* BaseLazyPromise
+/// @brief Task の Promise の共通部分
+/// @details 生成時には実行されず，co_await された時に開始する．
+///  終了時は待っている側へ対称転送 (symmetric transfer) で制御を移すため，
+///  co_await の連鎖が深くなってもスタックは伸びない
+class BaseLazyPromise : public runtime::TaskNode {
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    auto await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        -> std::coroutine_handle<> {
+      auto &promise = handle.promise();
+      auto continuation = promise.continuation_;
+
+      if (promise.detached_) {
+        handle.destroy();
+      }
+
+      return continuation;
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  std::coroutine_handle<> continuation_ = std::noop_coroutine();
+  bool detached_ = false;
+
+ public:
+  /// @brief フレームは FramePool から確保する
+  [[gnu::always_inline]] static void *operator new(std::size_t size) {
+    return FramePool::Allocate(size);
+  }
+
+  static void operator delete(void *ptr) { FramePool::Deallocate(ptr); }
+
+  /// @brief 終了時に制御を移すコルーチンを設定する
+  void SetContinuation(std::coroutine_handle<> continuation) {
+    continuation_ = continuation;
+  }
+
+  /// @brief 終了時にフレームを自ら破棄するようにする
+  void Detach() { detached_ = true; }
+
+  auto initial_suspend() noexcept { return std::suspend_always{}; }
+
+  auto final_suspend() noexcept { return FinalAwaiter{}; }
+
+  auto unhandled_exception() { std::terminate(); }
+};
+
+//* LazyPromise
+template <typename ReturnType>
+class LazyPromise : public BaseLazyPromise {
+  std::optional<ReturnType> value_;
+
+ public:
+  auto get_return_object() -> Task<ReturnType>;
+
+  void return_value(ReturnType value) { value_.emplace(std::move(value)); }
+
+  auto TakeValue() -> ReturnType { return std::move(*value_); }
+};
+
+template <>
+class LazyPromise<void> : public BaseLazyPromise {
+ public:
+  auto get_return_object() -> Task<void>;
+
+  void return_void() {}
+
+  void TakeValue() {}
+};
+
+//* Task
+/// @brief 遅延開始・単一継続のコルーチン
+/// @details Task はフレームを所有し，破棄時にフレームも破棄する．
+///  co_await した側が唯一の継続になる (複数から co_await してはならない)
+template <typename ReturnType>
+class [[nodiscard]] Task {
+ public:
+  using promise_type = LazyPromise<ReturnType>;
+  using Handle = std::coroutine_handle<promise_type>;
+
+ private:
+  Handle handle_;
+
+  struct Awaiter {
+    Handle handle;
+
+    bool await_ready() const noexcept { return !handle || handle.done(); }
+
+    template <typename Promise>
+    auto await_suspend(std::coroutine_handle<Promise> awaiting) noexcept
+        -> std::coroutine_handle<> {
+      if constexpr (runtime::TaskPromise<Promise>) {
+        // 待っている側と同じ優先度で (最初の再開から) 動く
+        handle.promise().SetPriority(awaiting.promise().GetPriority());
+      }
+
+      handle.promise().SetContinuation(awaiting);
+      return handle;
+    }
+
+    auto await_resume() -> ReturnType { return handle.promise().TakeValue(); }
+  };
+
+ public:
+  explicit Task(Handle handle) : handle_(handle) {}
+
+  Task(Task const &) = delete;
+  Task &operator=(Task const &) = delete;
+
+  Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(other.handle_, {});
+    }
+
+    return *this;
+  }
+
+  ~Task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  auto IsDone() const -> bool { return !handle_ || handle_.done(); }
+
+  auto operator co_await() && noexcept { return Awaiter{handle_}; }
+
+  auto operator co_await() & noexcept { return Awaiter{handle_}; }
+
+  /// @brief フレームの所有権を手放し，終了時に自ら破棄されるようにする
+  /// @details Loop::Spawn() に渡して独立したタスクとして実行するために用いる
+  auto Detach() -> Handle {
+    handle_.promise().Detach();
+    return std::exchange(handle_, {});
+  }
+};
+
+template <typename ReturnType>
+auto LazyPromise<ReturnType>::get_return_object() -> Task<ReturnType> {
+  auto handle = Task<ReturnType>::Handle::from_promise(*this);
+  SetHandle(handle);
+
+  return Task<ReturnType>{handle};
+}
+
+inline auto LazyPromise<void>::get_return_object() -> Task<void> {
+  auto handle = Task<void>::Handle::from_promise(*this);
+  SetHandle(handle);
+
+  return Task<void>{handle};
+}
+}  // namespace robobus::coroutine
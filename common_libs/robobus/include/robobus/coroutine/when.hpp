@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstddef>
+
+#include <array>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "frame_pool.hpp"
+#include "task.hpp"
+
+namespace robobus::coroutine {
+/// @brief WhenAll/WhenAny の結果として返す値の型 (void は std::monostate)
+template <typename T>
+using ValueOf = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+namespace detail {
+/// @brief 子タスクの終了を数え，条件を満たしたら親へ制御を移す
+struct Latch {
+  static constexpr std::size_t kNoWinner = static_cast<std::size_t>(-1);
+
+  /// 親を再開するまでに必要な終了数 (WhenAll は子の数，WhenAny は 1)
+  std::size_t remaining;
+  /// 最初に終了した子の番号
+  std::size_t winner = kNoWinner;
+  /// 待っている親 (子の開始中は空)
+  std::coroutine_handle<> parent = nullptr;
+
+  auto Done() const -> bool { return remaining == 0; }
+
+  auto Arrive(std::size_t index) -> std::coroutine_handle<> {
+    if (winner == kNoWinner) {
+      winner = index;
+    }
+
+    if (Done() || --remaining != 0 || !parent) {
+      return std::noop_coroutine();
+    }
+
+    return parent;
+  }
+};
+
+/// @brief 子タスクを待って結果を格納し，Latch に終了を知らせるコルーチン
+class Child {
+ public:
+  class promise_type {
+    friend class Child;
+
+    Latch *latch_ = nullptr;
+    std::size_t index_ = 0;
+
+    struct FinalAwaiter {
+      bool await_ready() const noexcept { return false; }
+
+      auto await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+          -> std::coroutine_handle<> {
+        auto &promise = handle.promise();
+        return promise.latch_->Arrive(promise.index_);
+      }
+
+      void await_resume() const noexcept {}
+    };
+
+   public:
+    [[gnu::always_inline]] static void *operator new(std::size_t size) {
+      return FramePool::Allocate(size);
+    }
+
+    static void operator delete(void *ptr) { FramePool::Deallocate(ptr); }
+
+    auto get_return_object() -> Child {
+      return Child{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    auto initial_suspend() noexcept { return std::suspend_always{}; }
+
+    auto final_suspend() noexcept { return FinalAwaiter{}; }
+
+    void return_void() {}
+
+    auto unhandled_exception() { std::terminate(); }
+  };
+
+ private:
+  std::coroutine_handle<promise_type> handle_;
+
+  explicit Child(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+ public:
+  Child() = default;
+
+  Child(Child const &) = delete;
+  Child &operator=(Child const &) = delete;
+
+  Child(Child &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+  Child &operator=(Child &&other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(other.handle_, {});
+    }
+
+    return *this;
+  }
+
+  /// @brief 子タスクがまだ終わっていなければ，フレームごと破棄して取り消す
+  ~Child() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  void Start(Latch &latch, std::size_t index) {
+    handle_.promise().latch_ = &latch;
+    handle_.promise().index_ = index;
+    handle_.resume();
+  }
+};
+
+template <typename T>
+auto RunChild(Task<T> task, std::optional<ValueOf<T>> &out) -> Child {
+  if constexpr (std::is_void_v<T>) {
+    co_await std::move(task);
+    out.emplace();
+  } else {
+    out.emplace(co_await std::move(task));
+  }
+}
+
+/// @brief 子タスクを順に開始し，Latch の条件を満たすまで親を中断する
+template <std::size_t N>
+struct StartAwaiter {
+  Latch &latch;
+  std::array<Child, N> &children;
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> parent) {
+    for (std::size_t i = 0; i < N && !latch.Done(); i++) {
+      children[i].Start(latch, i);
+    }
+
+    if (latch.Done()) {
+      return false;
+    }
+
+    latch.parent = parent;
+    return true;
+  }
+
+  void await_resume() const noexcept {}
+};
+
+template <typename... Ts, std::size_t... I>
+auto MakeChildren(std::tuple<Task<Ts>...> &tasks,
+                  std::tuple<std::optional<ValueOf<Ts>>...> &results,
+                  std::index_sequence<I...>)
+    -> std::array<Child, sizeof...(Ts)> {
+  return {RunChild(std::move(std::get<I>(tasks)), std::get<I>(results))...};
+}
+
+template <typename Variant, std::size_t I = 0, typename Results>
+auto TakeWinner(std::size_t winner, Results &results) -> Variant {
+  if constexpr (I + 1 < std::variant_size_v<Variant>) {
+    if (winner != I) {
+      return TakeWinner<Variant, I + 1>(winner, results);
+    }
+  }
+
+  return Variant{std::in_place_index<I>, std::move(*std::get<I>(results))};
+}
+}  // namespace detail
+
+/// @brief すべてのタスクを並行して実行し，すべて終わるまで待つ
+/// @return 各タスクの結果 (void は std::monostate)
+template <typename... Ts>
+auto WhenAll(Task<Ts>... tasks) -> Task<std::tuple<ValueOf<Ts>...>> {
+  std::tuple<Task<Ts>...> owned{std::move(tasks)...};
+  std::tuple<std::optional<ValueOf<Ts>>...> results;
+  detail::Latch latch{sizeof...(Ts)};
+
+  auto children = detail::MakeChildren(owned, results,
+                                       std::index_sequence_for<Ts...>{});
+  co_await detail::StartAwaiter<sizeof...(Ts)>{latch, children};
+
+  co_return std::apply(
+      [](auto &...result) {
+        return std::tuple<ValueOf<Ts>...>{std::move(*result)...};
+      },
+      results);
+}
+
+/// @brief すべてのタスクを並行して実行し，最初に終わったものの結果を返す
+/// @details 残りのタスクはフレームごと破棄される (Sleep などのタイマーも取り消される)
+/// @return index() が最初に終わったタスクの番号を表す std::variant
+template <typename... Ts>
+auto WhenAny(Task<Ts>... tasks) -> Task<std::variant<ValueOf<Ts>...>> {
+  std::tuple<Task<Ts>...> owned{std::move(tasks)...};
+  std::tuple<std::optional<ValueOf<Ts>>...> results;
+  detail::Latch latch{1};
+
+  auto children = detail::MakeChildren(owned, results,
+                                       std::index_sequence_for<Ts...>{});
+  co_await detail::StartAwaiter<sizeof...(Ts)>{latch, children};
+
+  auto result =
+      detail::TakeWinner<std::variant<ValueOf<Ts>...>>(latch.winner, results);
+
+  // 残りのタスクを今すぐ取り消す
+  for (auto &child : children) {
+    child = detail::Child{};
+  }
+
+  co_return result;
+}
+}  // namespace robobus::coroutine
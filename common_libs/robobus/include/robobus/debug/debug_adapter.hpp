@@ -1,12 +1,60 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
 #include <string_view>
 
+#include "../context/context_id.hpp"
+
 namespace robobus::debug {
+/// @brief デバッグ情報の送り先
+/// @details メッセージは番号 (ContextID) だけを付けて送られる．
+///  番号とパスの対応は RegisterContext() で一度だけ送られるので，
+///  パスの解決はホスト (デバッガ) 側で行う
 class DebugAdapter {
  public:
   virtual ~DebugAdapter() = default;
 
-  virtual void Message(std::string_view path, std::string_view text) = 0;
+  /// @brief 番号 id を (parent の子の) tag として登録する
+  /// @param parent 親の番号 (ルートの子の場合 context::kNoContext)
+  virtual void RegisterContext(context::ContextID id, context::ContextID parent,
+                               std::string_view tag) = 0;
+
+  virtual void Message(context::ContextID id, std::string_view text) = 0;
+
+  /// @brief 整数値を送る (既定では文字列にして Message() へ渡す)
+  virtual void Int(context::ContextID id, std::int32_t value) {
+    char buffer[16];
+    auto length = std::snprintf(buffer, sizeof(buffer), "%ld",
+                                static_cast<long>(value));
+    Message(id, std::string_view(buffer, length));
+  }
+
+  /// @brief 実数値を送る (既定では文字列にして Message() へ渡す)
+  virtual void Float(context::ContextID id, float value) {
+    char buffer[32];
+    auto length = std::snprintf(buffer, sizeof(buffer), "%g", value);
+    Message(id, std::string_view(buffer, length));
+  }
+
+  /// @brief バイト列を送る (既定では 16 進数の文字列にして Message() へ渡す)
+  /// @param size kMaxBytes まで (超えた分は捨てる)
+  virtual void Bytes(context::ContextID id, std::uint8_t const *data,
+                     std::size_t size) {
+    if (kMaxBytes < size) {
+      size = kMaxBytes;
+    }
+
+    char buffer[kMaxBytes * 2 + 1];
+    for (std::size_t i = 0; i < size; i++) {
+      std::snprintf(buffer + i * 2, 3, "%02x", data[i]);
+    }
+    Message(id, std::string_view(buffer, size * 2));
+  }
+
+  /// Bytes() で 1 度に送れるバイト数
+  static constexpr std::size_t kMaxBytes = 8;
 };
-}  // namespace robobus::debug
\ No newline at end of file
+}  // namespace robobus::debug
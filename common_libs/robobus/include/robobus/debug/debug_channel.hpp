@@ -0,0 +1,351 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <robotics/thread/thread.hpp>
+
+#include "../../internal/mpsc_queue.hpp"
+#include "debug_adapter.hpp"
+#include "debug_transport.hpp"
+
+namespace robobus::debug {
+/// @brief DebugChannel のバイト列に含まれる記録の種類 (記録の先頭 1 バイト)
+enum class RecordKind : std::uint8_t {
+  /// u16 id, u16 parent, u8 len, tag[len]
+  kRegister = 1,
+  /// u16 key, u32 time_us, u8 len, text[len]
+  kText = 2,
+  /// u16 key, u32 time_us, i32 value
+  kInt = 3,
+  /// u16 key, u32 time_us, f32 value
+  kFloat = 4,
+  /// u16 key, u32 time_us, u8 len, data[len]
+  kBytes = 5,
+  /// u32 count (前回のバッチ以降に捨てた記録の数)
+  kDropped = 6,
+  // 7 は version 2 の kTextPart (文字列の断片) で使っていた
+};
+
+/// @brief 型付きの値をまとめてバイナリで送るデバッグ用チャンネル
+/// @details Int()/Float()/Bytes()/Message() は記録をロックフリーのキューに
+///  積むだけなので，制御ループや割り込みからも呼び出せる．
+///  キューの要素は 16 バイトで，Message() の文字列は連続した要素に続けて
+///  積まれ，1 つの kText の記録として送られる (~100 文字の行で 7 要素)．
+///  flusher (StartFlusher() のスレッドもしくは Flush() の呼び出し) がキューを
+///  取り出してバッチにまとめ，DebugTransport へ 1 回の Write() で書き出す．
+///
+///  バッチの書式 (すべてリトルエンディアン):
+///  `'R' 'D' u8 version u16 body_len` に続いて RecordKind の記録が並ぶ．
+///  番号とパスの対応 (kRegister) は記録より先に送られる
+/// @tparam Clock 時刻印に用いる Clock
+/// @tparam Capacity キューの要素数 (2 の冪)．既定値は 100 ms ごとの Flush() で，
+///  1 kHz の値 100 個と ReportProfiles() の 16 Context 分 (112 要素) が収まる数
+template <typename Clock, std::size_t Capacity = 256>
+  requires std::chrono::is_clock_v<Clock>
+class DebugChannel : public DebugAdapter {
+ public:
+  static constexpr std::uint8_t kVersion = 3;
+  static constexpr std::size_t kHeaderSize = 5;
+  static constexpr std::size_t kBatchSize = 512;
+
+ private:
+  struct Record {
+    std::uint32_t time_us;
+    context::ContextID key;
+    RecordKind kind;
+    /// kText では文字列全体の長さ
+    std::uint8_t size;
+    /// kText では文字列の先頭 kMaxBytes 文字 (続きは後の要素に詰める)
+    std::uint8_t data[kMaxBytes];
+  };
+
+  /// kText の続きの要素 1 つに詰める文字数 (要素全体を文字列に使う)
+  static constexpr std::size_t kTextPerRecord = sizeof(Record);
+
+  /// @brief size 文字の kText が使う要素の数
+  static constexpr auto RecordsFor(std::size_t size) -> std::size_t {
+    return size <= kMaxBytes
+               ? 1
+               : 1 + (size - kMaxBytes + kTextPerRecord - 1) / kTextPerRecord;
+  }
+
+ public:
+  /// Message() で 1 度に送れる文字数 (超えた分は捨てる)．
+  /// 小さな Capacity ではキュー全体に収まる長さまで
+  static constexpr std::size_t kMaxText =
+      std::min<std::size_t>(0xFF, kMaxBytes + (Capacity - 1) * kTextPerRecord);
+
+ private:
+  struct Registration {
+    context::ContextID id;
+    context::ContextID parent;
+    std::string tag;
+  };
+
+  std::unique_ptr<DebugTransport> transport_;
+  internal::MpscQueue<Record, Capacity> queue_;
+  std::atomic<std::uint32_t> dropped_{0};
+
+  /// 登録は初期化時にしか起きないので，スピンロックで保護する
+  std::atomic_flag registrations_lock_ = ATOMIC_FLAG_INIT;
+  std::vector<Registration> registrations_;
+  std::size_t registrations_sent_ = 0;
+
+  /// 以下は flusher のみが触る
+  std::array<std::uint8_t, kBatchSize> batch_;
+  std::size_t batch_size_ = kHeaderSize;
+  std::uint32_t reported_drops_ = 0;
+  std::uint32_t batches_ = 0;
+
+  static auto Now() -> std::uint32_t {
+    using namespace std::chrono;
+    return static_cast<std::uint32_t>(
+        duration_cast<microseconds>(Clock::now().time_since_epoch()).count());
+  }
+
+  static auto Put16(std::uint8_t *out, std::uint16_t value) -> std::uint8_t * {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+    return out + 2;
+  }
+
+  static auto Put32(std::uint8_t *out, std::uint32_t value) -> std::uint8_t * {
+    out = Put16(out, value & 0xFFFF);
+    return Put16(out, value >> 16);
+  }
+
+  void Push(context::ContextID key, RecordKind kind, void const *data,
+            std::size_t size) {
+    Record record{};
+    record.time_us = Now();
+    record.key = key;
+    record.kind = kind;
+    record.size = static_cast<std::uint8_t>(size);
+    std::memcpy(record.data, data, size);
+
+    if (!queue_.TryPush(record)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void LockRegistrations() {
+    while (registrations_lock_.test_and_set(std::memory_order_acquire)) {
+    }
+  }
+
+  void UnlockRegistrations() {
+    registrations_lock_.clear(std::memory_order_release);
+  }
+
+  /// @brief バッチの残りが size に満たなければ書き出してから場所を確保する
+  auto Reserve(std::size_t size) -> std::uint8_t * {
+    if (kBatchSize < batch_size_ + size) {
+      Emit();
+    }
+
+    auto out = batch_.data() + batch_size_;
+    batch_size_ += size;
+    return out;
+  }
+
+  void Emit() {
+    if (batch_size_ == kHeaderSize) {
+      return;
+    }
+
+    batch_[0] = 'R';
+    batch_[1] = 'D';
+    batch_[2] = kVersion;
+    Put16(&batch_[3], static_cast<std::uint16_t>(batch_size_ - kHeaderSize));
+
+    transport_->Write(batch_.data(), batch_size_);
+    batch_size_ = kHeaderSize;
+    batches_++;
+  }
+
+  void EncodeRegistration(Registration const &registration) {
+    auto size = std::min<std::size_t>(registration.tag.size(), 0xFF);
+
+    auto out = Reserve(6 + size);
+    *out++ = static_cast<std::uint8_t>(RecordKind::kRegister);
+    out = Put16(out, registration.id);
+    out = Put16(out, registration.parent);
+    *out++ = static_cast<std::uint8_t>(size);
+    std::memcpy(out, registration.tag.data(), size);
+  }
+
+  void EncodeRecord(Record const &record) {
+    auto has_size = record.kind == RecordKind::kBytes;
+
+    auto out = Reserve(7 + (has_size ? 1 : 0) + record.size);
+    *out++ = static_cast<std::uint8_t>(record.kind);
+    out = Put16(out, record.key);
+    out = Put32(out, record.time_us);
+    if (has_size) {
+      *out++ = record.size;
+    }
+    std::memcpy(out, record.data, record.size);
+  }
+
+  /// @brief 先頭の要素 head に続く要素をキューから取り出し，1 つの kText にする
+  void EncodeText(Record const &head) {
+    auto out = Reserve(8 + head.size);
+    *out++ = static_cast<std::uint8_t>(RecordKind::kText);
+    out = Put16(out, head.key);
+    out = Put32(out, head.time_us);
+    *out++ = head.size;
+
+    auto size = std::min<std::size_t>(head.size, kMaxBytes);
+    std::memcpy(out, head.data, size);
+    out += size;
+
+    // 続きの要素は先頭より前に公開されているので，必ず取り出せる
+    for (auto remaining = head.size - size; remaining != 0;) {
+      Record record;
+      queue_.TryPop(record);
+
+      auto part = std::min(remaining, kTextPerRecord);
+      std::memcpy(out, &record, part);
+      out += part;
+      remaining -= part;
+    }
+  }
+
+ public:
+  explicit DebugChannel(std::unique_ptr<DebugTransport> transport)
+      : transport_(std::move(transport)) {}
+
+  DebugChannel(DebugChannel const &) = delete;
+  DebugChannel &operator=(DebugChannel const &) = delete;
+
+  void RegisterContext(context::ContextID id, context::ContextID parent,
+                       std::string_view tag) override {
+    LockRegistrations();
+    registrations_.push_back(Registration{id, parent, std::string(tag)});
+    UnlockRegistrations();
+  }
+
+  /// @details 連続した要素にまとめて積む (kMaxText 文字を超える分は切り捨てる)．
+  ///  空きが足りない場合は文字列ごと捨てるので，途中で欠けることはない
+  void Message(context::ContextID id, std::string_view text) override {
+    text = text.substr(0, kMaxText);
+    auto time_us = Now();
+
+    auto pushed = queue_.TryPush(
+        RecordsFor(text.size()), [id, text, time_us](Record &record,
+                                                     std::size_t index) {
+          if (index == 0) {
+            record.time_us = time_us;
+            record.key = id;
+            record.kind = RecordKind::kText;
+            record.size = static_cast<std::uint8_t>(text.size());
+            std::memcpy(record.data, text.data(),
+                        std::min(text.size(), kMaxBytes));
+            return;
+          }
+
+          auto offset = kMaxBytes + (index - 1) * kTextPerRecord;
+          std::memcpy(&record, text.data() + offset,
+                      std::min(text.size() - offset, kTextPerRecord));
+        });
+
+    if (!pushed) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void Int(context::ContextID id, std::int32_t value) override {
+    std::uint8_t data[4];
+    Put32(data, static_cast<std::uint32_t>(value));
+    Push(id, RecordKind::kInt, data, sizeof(data));
+  }
+
+  void Float(context::ContextID id, float value) override {
+    static_assert(sizeof(float) == 4);
+
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    std::uint8_t data[4];
+    Put32(data, bits);
+    Push(id, RecordKind::kFloat, data, sizeof(data));
+  }
+
+  void Bytes(context::ContextID id, std::uint8_t const *data,
+             std::size_t size) override {
+    Push(id, RecordKind::kBytes, data, std::min(size, kMaxBytes));
+  }
+
+  /// @brief 積まれた記録をバッチにまとめて書き出す (flusher 専用)
+  void Flush() {
+    LockRegistrations();
+    auto pending = std::vector<Registration>(
+        registrations_.begin() + registrations_sent_, registrations_.end());
+    registrations_sent_ = registrations_.size();
+    UnlockRegistrations();
+
+    for (auto const &registration : pending) {
+      EncodeRegistration(registration);
+    }
+
+    auto dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported_drops_) {
+      auto out = Reserve(5);
+      *out++ = static_cast<std::uint8_t>(RecordKind::kDropped);
+      Put32(out, dropped - reported_drops_);
+      reported_drops_ = dropped;
+    }
+
+    Record record;
+    while (queue_.TryPop(record)) {
+      if (record.kind == RecordKind::kText) {
+        EncodeText(record);
+      } else {
+        EncodeRecord(record);
+      }
+    }
+
+    Emit();
+  }
+
+  /// @brief 登録済みの番号とパスの対応を次の Flush() でもう一度送る
+  /// @details 後から接続したデバッガのため
+  void ResendRegistrations() {
+    LockRegistrations();
+    registrations_sent_ = 0;
+    UnlockRegistrations();
+  }
+
+  /// @brief period ごとに Flush() するスレッドを起動する
+  /// @details DebugChannel はプログラムの終了まで破棄しないこと
+  void StartFlusher(std::chrono::milliseconds period) {
+    robotics::system::Thread thread;
+    thread.SetThreadName("DebugChannel");
+    thread.Start([this, period]() {
+      while (true) {
+        Flush();
+        robotics::system::SleepFor(period);
+      }
+    });
+  }
+
+  /// @brief キューが満杯で捨てた記録の数
+  auto Dropped() const -> std::uint32_t {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  /// @brief 書き出したバッチの数 (flusher から読むこと)
+  auto Batches() const -> std::uint32_t { return batches_; }
+};
+}  // namespace robobus::debug
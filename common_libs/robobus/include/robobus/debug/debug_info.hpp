@@ -1,34 +1,54 @@
 #pragma once
 
-#include <string>
-#include <string_view>
+#include <cstddef>
+#include <cstdint>
 
 #include <chrono>
+#include <string_view>
 
-namespace robobus::context {
-template <typename Clock>
-  requires std::chrono::is_clock_v<Clock>
-class SharedContext;
-}
+#include "../context/context_id.hpp"
+#include "../context/root_context.hpp"
 
 namespace robobus::debug {
-
+/// @brief Context に紐づいたデバッグ情報の送り先
+/// @details 送り先は登録済みの番号 (ContextID) で表し，パスの文字列は持たない．
+///  RootContext を直接参照するので，RootContext より長く使ってはならない
 template <typename Clock>
+  requires std::chrono::is_clock_v<Clock>
 class DebugInfo {
  public:
-  explicit DebugInfo(context::SharedContext<Clock> ctx, std::string const& tag)
-      : ctx_(ctx), tag_(tag) {}
+  explicit DebugInfo(context::RootContext<Clock>& root, context::ContextID key)
+      : root_(&root), key_(key) {}
 
   auto Message(std::string_view message) -> void {
-    auto adapter = ctx_.Root().lock()->GetDebugAdapter();
-    if (adapter.has_value()) {
-      adapter.value()->Message(tag_, message);
+    if (auto adapter = root_->DebugAdapterPtr()) {
+      adapter->Message(key_, message);
+    }
+  }
+
+  auto Int(std::int32_t value) -> void {
+    if (auto adapter = root_->DebugAdapterPtr()) {
+      adapter->Int(key_, value);
+    }
+  }
+
+  auto Float(float value) -> void {
+    if (auto adapter = root_->DebugAdapterPtr()) {
+      adapter->Float(key_, value);
     }
   }
 
+  auto Bytes(std::uint8_t const* data, std::size_t size) -> void {
+    if (auto adapter = root_->DebugAdapterPtr()) {
+      adapter->Bytes(key_, data, size);
+    }
+  }
+
+  auto Key() const -> context::ContextID { return key_; }
+
  private:
-  context::SharedContext<Clock> ctx_;
-  std::string tag_;
+  context::RootContext<Clock>* root_;
+  context::ContextID key_;
 };
 
 }  // namespace robobus::debug
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace robobus::debug {
+/// @brief DebugChannel がまとめたバイト列を書き出す先 (シリアル，標準出力など)
+class DebugTransport {
+ public:
+  virtual ~DebugTransport() = default;
+
+  /// @brief バッチ 1 つ分を書き出す (DebugChannel の flusher からのみ呼ばれる)
+  virtual void Write(std::uint8_t const *data, std::size_t size) = 0;
+};
+}  // namespace robobus::debug
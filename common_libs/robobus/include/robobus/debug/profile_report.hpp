@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdio>
+
+#include <string_view>
+#include <vector>
+
+#include "../context/root_context.hpp"
+#include "../runtime/loop.hpp"
+#include "debug_adapter.hpp"
+
+namespace robobus::debug {
+#if ROBOBUS_ENABLE_PROFILING
+/// @brief Loop のタスクの計測値を Context ごとに集計し，DebugAdapter へ送る
+/// @details 送り先は `<ContextId>.profile` (Context に属さないタスクは `loop.profile`)．
+///  co_await した子のコルーチン (Loop::ForEachNestedProfile()) は親の Context を
+///  引き継ぐので，その実行時間と遅れも親の Context に数える (tasks には数えない)．
+///  送り先の番号は初回だけ登録して TaskNode (子は Loop の NestedProfile) に覚えておく．
+///  書式: `tasks=<n> resumes=<n> run_total_us=<f> run_max_us=<f>
+///  late_mean_us=<f> late_max_us=<f>`
+template <typename Clock>
+void ReportProfiles(context::RootContext<Clock> &root, DebugAdapter &adapter) {
+  using context::ContextID;
+  using runtime::CycleCounter;
+  using runtime::TaskNode;
+  using runtime::TaskProfile;
+
+  struct Entry {
+    ContextID report_id;
+    int tasks;
+    TaskProfile profile;
+  };
+
+  auto report_id_of = [&root](ContextID owner) {
+    if (owner == context::kNoContext) {
+      owner = root.Intern(context::kNoContext, "loop");
+    }
+    return root.Intern(owner, "profile");
+  };
+
+  std::vector<Entry> entries;
+  auto add = [&entries](ContextID report_id, int tasks,
+                        TaskProfile const &profile) {
+    for (auto &entry : entries) {
+      if (entry.report_id == report_id) {
+        entry.tasks += tasks;
+        entry.profile.Merge(profile);
+        return;
+      }
+    }
+
+    entries.push_back(Entry{report_id, tasks, profile});
+  };
+
+  auto &loop = root.GetLoop();
+  loop.ForEachTask([&report_id_of, &add](TaskNode &task) {
+    if (task.ReportID() == context::kNoContext) {
+      task.SetReportID(report_id_of(task.Owner()));
+    }
+
+    add(task.ReportID(), 1, task.Profile());
+  });
+
+  loop.ForEachNestedProfile([&report_id_of, &add](ContextID owner,
+                                                   auto &nested) {
+    if (nested.report_id == context::kNoContext) {
+      nested.report_id = report_id_of(owner);
+    }
+
+    add(nested.report_id, 0, nested.profile);
+  });
+
+  for (auto const &entry : entries) {
+    auto const &profile = entry.profile;
+    auto to_us = [](std::uint64_t cycles) {
+      return CycleCounter::ToNanoseconds(cycles) / 1E3f;
+    };
+
+    auto late_mean_ns =
+        profile.timer_wakes == 0
+            ? 0
+            : profile.total_lateness_ns / static_cast<std::int64_t>(profile.timer_wakes);
+
+    char buffer[160];
+    auto length = std::snprintf(
+        buffer, sizeof(buffer),
+        "tasks=%d resumes=%lu run_total_us=%.1f run_max_us=%.1f "
+        "late_mean_us=%.1f late_max_us=%.1f",
+        entry.tasks, static_cast<unsigned long>(profile.resumes),
+        to_us(profile.total_cycles), to_us(profile.max_cycles),
+        late_mean_ns / 1E3f, profile.max_lateness_ns / 1E3f);
+    if (length < 0) {
+      continue;
+    }
+
+    if (sizeof(buffer) <= static_cast<std::size_t>(length)) {
+      length = sizeof(buffer) - 1;
+    }
+
+    adapter.Message(entry.report_id, std::string_view(buffer, length));
+  }
+}
+#endif
+}  // namespace robobus::debug
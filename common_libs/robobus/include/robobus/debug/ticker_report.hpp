@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdio>
+
+#include <chrono>
+#include <string_view>
+
+#include "../runtime/ticker.hpp"
+#include "debug_info.hpp"
+
+namespace robobus::debug {
+/// @brief Ticker の統計情報を DebugInfo へ送る
+/// @details 書式: `ticks=<n> overruns=<n> skipped=<n> jitter_mean_us=<f> jitter_max_us=<f>`
+template <typename Clock>
+void ReportTicker(DebugInfo<Clock> &info,
+                  runtime::TickerStats<Clock> const &stats) {
+  using Micros = std::chrono::duration<float, std::micro>;
+
+  char buffer[128];
+  auto length = std::snprintf(
+      buffer, sizeof(buffer),
+      "ticks=%llu overruns=%llu skipped=%llu jitter_mean_us=%.1f "
+      "jitter_max_us=%.1f",
+      static_cast<unsigned long long>(stats.ticks),
+      static_cast<unsigned long long>(stats.overruns),
+      static_cast<unsigned long long>(stats.skipped),
+      Micros(stats.MeanJitter()).count(), Micros(stats.max_jitter).count());
+  if (length < 0) {
+    return;
+  }
+
+  if (sizeof(buffer) <= static_cast<std::size_t>(length)) {
+    length = sizeof(buffer) - 1;
+  }
+
+  info.Message(std::string_view(buffer, length));
+}
+}  // namespace robobus::debug
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <array>
+#include <memory>
+#include <type_traits>
+
+#include <robotics/platform/panic.hpp>
+
+#include "../router/message_router.hpp"
+#include "../../internal/signal.hpp"
+#include "../../types/device_id.hpp"
+#include "../../types/message_id.hpp"
+#include "../../types/multicast_session_id.hpp"
+
+namespace robobus::multicast {
+/// @brief セッションに届いたサンプル
+template <typename T>
+struct MulticastSample {
+  T value;
+  /// 送信元のデバイス ID
+  std::uint8_t sender;
+};
+
+struct MulticastStats {
+  std::uint32_t published = 0;
+  /// CAN の送信キューが一杯で送れなかった数
+  std::uint32_t publish_failures = 0;
+  std::uint32_t received = 0;
+  /// 長さが sizeof(T) と合わず捨てたフレームの数
+  std::uint32_t malformed = 0;
+};
+
+/// @brief 型付きのサンプルを 1 フレームで配る Multicast セッション
+/// @details サンプルは 1 つの CAN フレームにそのまま (ホストのバイト順で) 詰める．
+///  受信したサンプルはセッションが持つ Depth 個のリングバッファに 1 度だけ書き込み，
+///  購読者 (Subscriber) はそれぞれの読み出し位置からリング上のサンプルを
+///  const 参照で受け取る．購読者が何人いても，バスを流れるのは
+///  1 サンプルにつき 1 フレームで，受信側の複製も 1 回で済む．
+///  読むのが遅れた購読者は古いものから読み飛ばす (drop-oldest)．
+///  Publish() したサンプルは自ノードの購読者にも届く
+/// @tparam T サンプルの型 (trivially copyable で 8 バイト以下)
+/// @tparam Depth リングバッファの長さ (2 の冪)
+template <typename T, std::size_t Depth = 8>
+class MulticastSession {
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(sizeof(T) <= types::CanFrame::kCapacity,
+                "Multicast sample must fit in a single CAN frame");
+  static_assert(Depth != 0 && (Depth & (Depth - 1)) == 0,
+                "Depth must be a power of 2");
+
+  std::shared_ptr<router::MessageRouter> router_;
+  types::MessageID tx_id_;
+  std::uint8_t self_device_id_;
+
+  std::array<MulticastSample<T>, Depth> ring_{};
+  /// これまでに書き込んだサンプルの数 (次に書き込む位置)
+  std::uint32_t head_ = 0;
+
+  MulticastStats stats_;
+
+  internal::SignalTx<std::uint32_t> updated_tx_{
+      std::make_shared<internal::Signal<std::uint32_t>>()};
+
+  void Store(T const &value, std::uint8_t sender) {
+    ring_[head_ & (Depth - 1)] = MulticastSample<T>{value, sender};
+    head_++;
+    updated_tx_.Fire(head_);
+  }
+
+ public:
+  /// @brief セッションを読む購読者
+  /// @details 読み出し位置だけを持つので，作るのも破棄するのも自由．
+  ///  セッションより先に破棄すること
+  class Subscriber {
+    friend class MulticastSession;
+
+    MulticastSession const *session_;
+    std::uint32_t cursor_;
+    std::uint32_t dropped_ = 0;
+
+    Subscriber(MulticastSession const &session, std::uint32_t cursor)
+        : session_(&session), cursor_(cursor) {}
+
+   public:
+    /// @brief まだ読んでいないサンプルを古い順に f に渡す
+    /// @details Depth 個を超えて遅れていた分は読み飛ばして Dropped() に数える．
+    ///  渡した参照はリングが一周するまで (通常は f の中でのみ) 有効
+    /// @return f に渡したサンプルの数
+    template <typename F>
+    auto Poll(F &&f) -> std::size_t {
+      auto head = session_->head_;
+      if (Depth < head - cursor_) {
+        dropped_ += head - cursor_ - Depth;
+        cursor_ = head - Depth;
+      }
+
+      std::size_t count = 0;
+      for (; cursor_ != head; cursor_++, count++) {
+        f(session_->ring_[cursor_ & (Depth - 1)]);
+      }
+      return count;
+    }
+
+    /// @brief まだ読んでいないサンプルの数 (Depth を超えた分も含む)
+    auto Pending() const -> std::uint32_t { return session_->head_ - cursor_; }
+
+    /// @brief 読み飛ばしたサンプルの数
+    auto Dropped() const -> std::uint32_t { return dropped_; }
+  };
+
+  /// @brief サンプルが届いた (値は書き込んだサンプルの累計)
+  internal::SignalRx<std::uint32_t> updated{updated_tx_};
+
+  /// @param router 受信したフレームを受け取る MessageRouter
+  /// @param session_id セッション ID (同じセッションの全ての送信元から受け取る)
+  /// @param self_device_id Publish() する時の送信元のデバイス ID
+  MulticastSession(std::shared_ptr<router::MessageRouter> router,
+                   types::MulticastSessionID session_id,
+                   types::DeviceID self_device_id)
+      : router_(std::move(router)),
+        tx_id_(types::MessageID::CreateMulticast(session_id, self_device_id)),
+        self_device_id_(self_device_id.GetDeviceID()) {
+    auto bound = router_->Bind(
+        tx_id_, [this](router::DecodedID const &id,
+                       types::CanFrame const &frame) {
+          if (frame.size != sizeof(T)) {
+            stats_.malformed++;
+            return;
+          }
+
+          T value;
+          std::memcpy(&value, frame.data.data(), sizeof(T));
+          stats_.received++;
+          Store(value, id.sender);
+        });
+    if (!bound) {
+      robotics::system::panic(
+          "MulticastSession: session is already bound to the router");
+    }
+  }
+
+  ~MulticastSession() { router_->Unbind(tx_id_); }
+
+  MulticastSession(MulticastSession const &) = delete;
+  MulticastSession &operator=(MulticastSession const &) = delete;
+
+  /// @brief サンプルを 1 フレームで送り，自ノードの購読者にも渡す
+  /// @return CAN の送信キューに積めた場合 true
+  auto Publish(T const &value) -> bool {
+    std::array<std::uint8_t, sizeof(T)> data;
+    std::memcpy(data.data(), &value, sizeof(T));
+
+    auto sent = router_->Send(types::CanFrame::Create(
+        tx_id_.GetMsgID(), data, types::CanFrameFlags::kExtended));
+    if (sent) {
+      stats_.published++;
+    } else {
+      stats_.publish_failures++;
+    }
+
+    Store(value, self_device_id_);
+    return sent;
+  }
+
+  /// @brief 購読者を作る
+  /// @details 途中から参加した購読者も，最新のサンプルが 1 つあればそれから読む
+  auto Subscribe() const -> Subscriber {
+    return Subscriber(*this, head_ == 0 ? 0 : head_ - 1);
+  }
+
+  /// @brief 最新のサンプル (まだ何も届いていなければ nullptr)
+  auto Latest() const -> MulticastSample<T> const * {
+    if (head_ == 0) {
+      return nullptr;
+    }
+    return &ring_[(head_ - 1) & (Depth - 1)];
+  }
+
+  auto Stats() const -> MulticastStats const & { return stats_; }
+};
+}  // namespace robobus::multicast
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <memory>
+#include <optional>
+
+#include "../can/can_bus.hpp"
+#include "../../internal/delegate.hpp"
+#include "../../internal/signal.hpp"
+#include "../../types/message_id.hpp"
+
+/// @def ROBOBUS_ROUTER_MAX_HANDLERS
+/// @brief MessageRouter に Bind() できるハンドラの数 (255 以下)
+#ifndef ROBOBUS_ROUTER_MAX_HANDLERS
+#define ROBOBUS_ROUTER_MAX_HANDLERS 32
+#endif
+
+/// @def ROBOBUS_ROUTER_PIPE_SLOTS
+/// @brief P2P / Raw P2P の表の大きさ (2 の冪，ハンドラの数の 2 倍以上)
+#ifndef ROBOBUS_ROUTER_PIPE_SLOTS
+#define ROBOBUS_ROUTER_PIPE_SLOTS 64
+#endif
+
+namespace robobus::router {
+/// @brief 1 度だけ解読した CAN ID
+/// @details ビット配置は docs/network.md の通り
+struct DecodedID {
+  types::MessageType type;
+  /// @brief 表を引くキー
+  /// @details Control: `d1 << 2 | c`, P2P: `p1 << 2 | c`,
+  ///  Raw P2P: `d1 << 8 | d2`, Multicast: `s1`
+  std::uint16_t key;
+  /// @brief 送信元のデバイス ID (Raw P2P と Multicast のみ．それ以外は 0)
+  std::uint8_t sender;
+
+  /// @brief CAN ID を解読する
+  /// @details ID の値だけを見る．IDE やフレームの種類は MessageRouter::Route() で見る
+  /// @return RoboBus の ID でない (20bit を超える，種類や予約ビットが不正) 場合
+  ///  std::nullopt
+  static constexpr auto Decode(std::uint32_t id) -> std::optional<DecodedID> {
+    if (0xFFFFF < id) {
+      return std::nullopt;
+    }
+
+    auto low = static_cast<std::uint16_t>(id & 0xFFFF);
+    switch (id >> 16) {
+      case 0:
+        // d1 と c の間の 6bit は 0
+        if ((low & 0x00FC) != 0) {
+          return std::nullopt;
+        }
+        return DecodedID{types::MessageType::kControl,
+                         static_cast<std::uint16_t>(low >> 8 << 2 | (low & 3)),
+                         0};
+      case 1:
+        return DecodedID{types::MessageType::kRawP2P, low,
+                         static_cast<std::uint8_t>(low & 0xFF)};
+      case 2:
+        return DecodedID{types::MessageType::kP2P, low, 0};
+      case 3:
+        return DecodedID{types::MessageType::kMulticast,
+                         static_cast<std::uint16_t>(low >> 8),
+                         static_cast<std::uint8_t>(low & 0xFF)};
+      default:
+        return std::nullopt;
+    }
+  }
+};
+
+struct RouterStats {
+  /// ハンドラに渡したフレームの数
+  std::uint32_t routed = 0;
+  /// RoboBus の ID だがハンドラが無かったフレームの数
+  std::uint32_t unrouted = 0;
+  /// RoboBus の ID でないフレーム (標準 ID，エラー・リモートフレームを含む) の数
+  std::uint32_t foreign = 0;
+};
+
+/// @brief 受信したフレームを MessageID ごとのハンドラに振り分けるもの
+/// @details CAN の rx に 1 つだけ繋がり，ID を 1 度だけ解読して表を引く．
+///  Control (デバイス ID × マーカー) と Multicast (セッション ID) は
+///  ID をそのまま添字にした表，P2P と Raw P2P は線形探査のハッシュ表を使うので，
+///  Bind() したパイプやセッションの数によらず振り分けの手間は一定．
+///  表にはハンドラの番号 (1 byte) だけを持ち，ハンドラ自体は共通の領域に置く．
+///  RoboBus のフレームは拡張 ID のデータフレームなので，エラーフレーム，
+///  リモートフレーム，(IDE が分かるバスでは) 標準 ID のフレームは foreign に回す
+class MessageRouter {
+ public:
+  using Handler = internal::Delegate<void(DecodedID const &,
+                                          types::CanFrame const &)>;
+
+  static constexpr std::size_t kMaxHandlers = ROBOBUS_ROUTER_MAX_HANDLERS;
+  static constexpr std::size_t kPipeSlots = ROBOBUS_ROUTER_PIPE_SLOTS;
+
+ private:
+  static_assert(kMaxHandlers < 0xFF);
+  static_assert((kPipeSlots & (kPipeSlots - 1)) == 0,
+                "ROBOBUS_ROUTER_PIPE_SLOTS must be a power of 2");
+  static_assert(kMaxHandlers * 2 <= kPipeSlots);
+
+  static constexpr std::uint8_t kNoHandler = 0xFF;
+  static constexpr std::uint32_t kEmptyPipe = 0xFFFFFFFF;
+
+  struct PipeSlot {
+    /// `type << 16 | key` (空きは kEmptyPipe)
+    std::uint32_t key = kEmptyPipe;
+    std::uint8_t handler = kNoHandler;
+  };
+
+  std::shared_ptr<can::CanBus> can_;
+  internal::SignalConnection<types::CanFrame> rx_connection_;
+  /// 拡張 ID であることを確かめる (CanBus::PreservesIde())
+  bool require_extended_;
+
+  std::array<Handler, kMaxHandlers> handlers_;
+  /// Control: `d1 << 2 | c` → ハンドラの番号
+  std::array<std::uint8_t, 256 * 4> control_;
+  /// Multicast: `s1` → ハンドラの番号
+  std::array<std::uint8_t, 256> multicast_;
+  std::array<PipeSlot, kPipeSlots> pipes_{};
+
+  Handler foreign_;
+  RouterStats stats_;
+
+  static auto PipeKey(DecodedID const &id) -> std::uint32_t {
+    return static_cast<std::uint32_t>(id.type) << 16 | id.key;
+  }
+
+  static auto Home(std::uint32_t key) -> std::size_t {
+    // Fibonacci hashing (上位ビットを使う)
+    return (key * 0x9E3779B1u) >> 16 & (kPipeSlots - 1);
+  }
+
+  auto FindPipe(std::uint32_t key) const -> std::size_t {
+    for (auto i = Home(key);; i = (i + 1) & (kPipeSlots - 1)) {
+      if (pipes_[i].key == key || pipes_[i].key == kEmptyPipe) {
+        return i;
+      }
+    }
+  }
+
+  /// @brief 線形探査の列を詰めながら slot を空ける (墓標を残さない)
+  void ErasePipe(std::size_t slot) {
+    auto hole = slot;
+    for (auto i = (slot + 1) & (kPipeSlots - 1); pipes_[i].key != kEmptyPipe;
+         i = (i + 1) & (kPipeSlots - 1)) {
+      auto home = Home(pipes_[i].key);
+      // home が (hole, i] の外にあれば hole へ移せる
+      auto distance_to_i = (i - home) & (kPipeSlots - 1);
+      auto distance_to_hole = (i - hole) & (kPipeSlots - 1);
+      if (distance_to_hole <= distance_to_i) {
+        pipes_[hole] = pipes_[i];
+        hole = i;
+      }
+    }
+    pipes_[hole] = PipeSlot{};
+  }
+
+  /// @brief ID に対応する表の要素 (Control / Multicast)，無ければ nullptr
+  auto FlatEntry(DecodedID const &id) -> std::uint8_t * {
+    switch (id.type) {
+      case types::MessageType::kControl:
+        return &control_[id.key];
+      case types::MessageType::kMulticast:
+        return &multicast_[id.key];
+      default:
+        return nullptr;
+    }
+  }
+
+  auto Lookup(DecodedID const &id) const -> std::uint8_t {
+    switch (id.type) {
+      case types::MessageType::kControl:
+        return control_[id.key];
+      case types::MessageType::kMulticast:
+        return multicast_[id.key];
+      default:
+        return pipes_[FindPipe(PipeKey(id))].handler;
+    }
+  }
+
+ public:
+  explicit MessageRouter(std::shared_ptr<can::CanBus> can)
+      : can_(std::move(can)), require_extended_(can_->PreservesIde()) {
+    control_.fill(kNoHandler);
+    multicast_.fill(kNoHandler);
+
+    rx_connection_ = can_->rx.Connect(
+        [this](types::CanFrame const &frame) { Route(frame); });
+  }
+
+  ~MessageRouter() { rx_connection_.Disconnect(); }
+
+  MessageRouter(MessageRouter const &) = delete;
+  MessageRouter &operator=(MessageRouter const &) = delete;
+
+  /// @brief id のフレームを handler に渡すようにする
+  /// @details Multicast はセッション ID だけで引くので，
+  ///  同じセッションの全ての送信元のフレームが渡される
+  /// @return 既に Bind() されている，ハンドラの領域が一杯，もしくは handler が空の場合 false
+  auto Bind(types::MessageID id, Handler handler) -> bool {
+    auto decoded = DecodedID::Decode(id.GetMsgID());
+    if (!decoded || !handler) {
+      return false;
+    }
+
+    std::size_t index = 0;
+    while (index < kMaxHandlers && handlers_[index]) {
+      index++;
+    }
+    if (index == kMaxHandlers) {
+      return false;
+    }
+
+    if (auto *entry = FlatEntry(*decoded)) {
+      if (*entry != kNoHandler) {
+        return false;
+      }
+      *entry = static_cast<std::uint8_t>(index);
+    } else {
+      auto key = PipeKey(*decoded);
+      auto slot = FindPipe(key);
+      if (pipes_[slot].key == key) {
+        return false;
+      }
+      pipes_[slot] = PipeSlot{key, static_cast<std::uint8_t>(index)};
+    }
+
+    handlers_[index] = std::move(handler);
+    return true;
+  }
+
+  /// @brief Bind() を取り消す (Bind() されていなければ何もしない)
+  void Unbind(types::MessageID id) {
+    auto decoded = DecodedID::Decode(id.GetMsgID());
+    if (!decoded) {
+      return;
+    }
+
+    std::uint8_t index;
+    if (auto *entry = FlatEntry(*decoded)) {
+      index = *entry;
+      *entry = kNoHandler;
+    } else {
+      auto slot = FindPipe(PipeKey(*decoded));
+      index = pipes_[slot].handler;
+      if (pipes_[slot].key != kEmptyPipe) {
+        ErasePipe(slot);
+      }
+    }
+
+    if (index != kNoHandler) {
+      handlers_[index].Reset();
+    }
+  }
+
+  /// @brief RoboBus 以外の ID のフレームを渡す先 (DecodedID は使わない)
+  void OnForeign(Handler handler) { foreign_ = std::move(handler); }
+
+  /// @brief フレームを振り分ける (CAN の rx から呼ばれる)
+  void Route(types::CanFrame const &frame) {
+    auto decoded = DecodedID::Decode(frame.id);
+    auto is_data_frame =
+        !types::HasFlag(frame.flags, types::CanFrameFlags::kError) &&
+        !types::HasFlag(frame.flags, types::CanFrameFlags::kRemote);
+    auto is_extended =
+        !require_extended_ ||
+        types::HasFlag(frame.flags, types::CanFrameFlags::kExtended);
+    if (!decoded || !is_data_frame || !is_extended) {
+      stats_.foreign++;
+      if (foreign_) {
+        foreign_(DecodedID{}, frame);
+      }
+      return;
+    }
+
+    auto index = Lookup(*decoded);
+    if (index == kNoHandler) {
+      stats_.unrouted++;
+      return;
+    }
+
+    stats_.routed++;
+    handlers_[index](*decoded, frame);
+  }
+
+  /// @brief フレームを送る
+  auto Send(types::CanFrame const &frame) -> bool { return can_->Send(frame); }
+
+  auto Bus() const -> can::CanBus & { return *can_; }
+
+  auto Stats() const -> RouterStats const & { return stats_; }
+};
+}  // namespace robobus::router
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../../internal/intrusive_list.hpp"
+
+namespace robobus::runtime {
+class CancellationSource;
+
+struct CancellationTag;
+
+/// @brief 取り消し要求を受け取るもの
+/// @details CancellationSource に侵入型リストとして登録される．
+///  Cancel() されるとリストから外されてから OnCancel() が呼ばれる
+class CancellationHook : public internal::IntrusiveListHook<CancellationTag> {
+ public:
+  virtual void OnCancel() = 0;
+
+ protected:
+  ~CancellationHook() = default;
+};
+
+/// @brief 取り消し要求を参照するためのトークン
+/// @details 元の CancellationSource より長く使ってはならない．
+///  既定構築したトークンは取り消されることがない
+class CancellationToken {
+  CancellationSource *source_ = nullptr;
+
+ public:
+  CancellationToken() = default;
+  explicit CancellationToken(CancellationSource &source) : source_(&source) {}
+
+  /// @brief 取り消される可能性があるか
+  auto CanBeCancelled() const -> bool { return source_ != nullptr; }
+
+  inline auto IsCancelled() const -> bool;
+
+  /// @brief 取り消し要求を受け取るよう登録する
+  /// @return 既に取り消されている場合 false (登録しない)
+  inline auto Register(CancellationHook &hook) const -> bool;
+};
+
+/// @brief 取り消し要求を発行する側
+/// @details Cancel() すると，登録されている Sleep などの待機が O(1) で取り消され，
+///  待っていたコルーチンが再開する
+class CancellationSource {
+  friend class CancellationToken;
+
+  internal::IntrusiveList<CancellationHook, CancellationTag> hooks_;
+  bool cancelled_ = false;
+
+ public:
+  CancellationSource() = default;
+  CancellationSource(CancellationSource const &) = delete;
+  CancellationSource &operator=(CancellationSource const &) = delete;
+
+  auto Token() -> CancellationToken { return CancellationToken{*this}; }
+
+  auto IsCancelled() const -> bool { return cancelled_; }
+
+  /// @brief 取り消しを要求する (2 回目以降は何もしない)
+  void Cancel() {
+    if (cancelled_) {
+      return;
+    }
+    cancelled_ = true;
+
+    while (auto hook = hooks_.PopFront()) {
+      hook->OnCancel();
+    }
+  }
+};
+
+inline auto CancellationToken::IsCancelled() const -> bool {
+  return source_ != nullptr && source_->cancelled_;
+}
+
+inline auto CancellationToken::Register(CancellationHook &hook) const -> bool {
+  if (source_ == nullptr) {
+    return true;
+  }
+
+  if (source_->cancelled_) {
+    return false;
+  }
+
+  source_->hooks_.PushBack(hook);
+  return true;
+}
+}  // namespace robobus::runtime
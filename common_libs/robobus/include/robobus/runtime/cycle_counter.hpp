@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+
+#include <chrono>
+
+#if defined(__MBED__)
+#include <cmsis.h>
+#endif
+
+#if defined(__MBED__) && defined(DWT_CTRL_CYCCNTENA_Msk)
+#define ROBOBUS_CYCLE_COUNTER_DWT 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ROBOBUS_CYCLE_COUNTER_TSC 1
+#endif
+
+namespace robobus::runtime {
+/// @brief 処理時間の計測に用いるサイクルカウンタ
+/// @details Cortex-M3 以上では DWT->CYCCNT，x86 では TSC を読む．
+///  それ以外では steady_clock の値 (ns) をそのまま用いる
+class CycleCounter {
+ public:
+#if defined(ROBOBUS_CYCLE_COUNTER_DWT)
+  /// CYCCNT は 32 bit なので，差分は符号なしの引き算で求める
+  using Cycles = std::uint32_t;
+#else
+  using Cycles = std::uint64_t;
+#endif
+
+ private:
+#if defined(ROBOBUS_CYCLE_COUNTER_TSC)
+  /// TSC の周波数を求めるための基準点
+  static inline Cycles epoch_cycles_ = 0;
+  static inline std::chrono::steady_clock::time_point epoch_time_{};
+#endif
+
+ public:
+  /// @brief カウンタを有効にする (何度呼び出してもよい)
+  static void Init() {
+#if defined(ROBOBUS_CYCLE_COUNTER_DWT)
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0) {
+      CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+      DWT->CYCCNT = 0;
+      DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+#elif defined(ROBOBUS_CYCLE_COUNTER_TSC)
+    if (epoch_cycles_ == 0) {
+      epoch_time_ = std::chrono::steady_clock::now();
+      epoch_cycles_ = __rdtsc();
+    }
+#endif
+  }
+
+  [[gnu::always_inline]] static inline auto Now() -> Cycles {
+#if defined(ROBOBUS_CYCLE_COUNTER_DWT)
+    return DWT->CYCCNT;
+#elif defined(ROBOBUS_CYCLE_COUNTER_TSC)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+  }
+
+  /// @brief サイクル数を時間に換算する
+  /// @details TSC の場合は Init() からの経過時間で周波数を推定する．
+  ///  累計のサイクル数を渡しても溢れないよう，秒とその端数に分けて換算する
+  static auto ToNanoseconds(std::uint64_t cycles) -> std::uint64_t {
+#if defined(ROBOBUS_CYCLE_COUNTER_DWT)
+    std::uint64_t hz = SystemCoreClock;
+    return cycles / hz * 1000000000ULL + cycles % hz * 1000000000ULL / hz;
+#elif defined(ROBOBUS_CYCLE_COUNTER_TSC)
+    auto elapsed_cycles = __rdtsc() - epoch_cycles_;
+    auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - epoch_time_)
+                          .count();
+    if (epoch_cycles_ == 0 || elapsed_cycles == 0) {
+      return 0;
+    }
+
+    return static_cast<std::uint64_t>(static_cast<double>(cycles) *
+                                      elapsed_ns / elapsed_cycles);
+#else
+    return cycles;
+#endif
+  }
+};
+}  // namespace robobus::runtime
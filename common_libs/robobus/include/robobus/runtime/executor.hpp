@@ -0,0 +1,379 @@
+#pragma once
+
+#if !defined(__MBED__)
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "loop.hpp"
+#include "virtual_clock.hpp"
+
+namespace robobus::runtime {
+/// @brief 複数の Loop を N 本のワーカースレッドで実行する Executor (ホスト専用)
+/// @details Loop 単位でワーカーに割り当てるため，1 つの Loop (とその Context 木) が
+///  同時に複数のスレッドで実行されることはない．
+///  実行可能な Loop は各ワーカーの両端キューに積まれ，手の空いたワーカーは
+///  他のワーカーのキューから盗む (work stealing)．
+///  どの Loop にも仕事が無い時は，最も早いタイマーの期限か Wake() まで眠る
+/// @tparam Clock Loop の Clock (実時間の時計であること)
+template <typename Clock>
+  requires std::chrono::is_clock_v<Clock> && (!AdvanceableClock<Clock>)
+class Executor {
+ public:
+  struct Stats {
+    /// Loop::Poll() を呼んだ回数
+    std::uint64_t polls;
+    /// 他のワーカーから Loop を盗んだ回数
+    std::uint64_t steals;
+    /// 仕事が無く眠った回数
+    std::uint64_t sleeps;
+  };
+
+ private:
+  enum class State : std::uint8_t {
+    /// 仕事が無い (タイマー待ち)
+    kIdle,
+    /// いずれかのキューに積まれている
+    kQueued,
+    /// ワーカーが実行中
+    kRunning,
+    /// 実行中に Wake() された (実行後にもう一度積む)
+    kNotified,
+  };
+
+  struct Slot {
+    Executor *executor;
+    Loop<Clock> *loop;
+    std::atomic<State> state{State::kQueued};
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Slot *> deque;
+    std::thread thread;
+
+    std::atomic<std::uint64_t> polls{0};
+    std::atomic<std::uint64_t> steals{0};
+    std::atomic<std::uint64_t> sleeps{0};
+  };
+
+  struct TimerEntry {
+    typename Clock::time_point deadline;
+    Slot *slot;
+
+    friend bool operator<(TimerEntry const &a, TimerEntry const &b) {
+      return b.deadline < a.deadline;
+    }
+  };
+
+  std::size_t worker_count_;
+  std::vector<std::unique_ptr<Slot>> slots_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  /// 以下は mutex_ で保護する
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Slot *> inject_;
+  std::vector<TimerEntry> timers_;
+
+  std::atomic<bool> running_{false};
+  std::atomic<std::size_t> sleeping_{0};
+
+  /// 停止したワーカーの統計情報
+  Stats stopped_stats_{};
+
+  static void Accumulate(Stats &stats, Worker const &worker) {
+    stats.polls += worker.polls.load(std::memory_order_relaxed);
+    stats.steals += worker.steals.load(std::memory_order_relaxed);
+    stats.sleeps += worker.sleeps.load(std::memory_order_relaxed);
+  }
+
+  static void OnWake(void *context) {
+    auto slot = static_cast<Slot *>(context);
+    slot->executor->Notify(*slot);
+  }
+
+  /// @brief 他スレッドからの Wake()
+  void Notify(Slot &slot) {
+    auto state = slot.state.load(std::memory_order_acquire);
+    while (true) {
+      switch (state) {
+        case State::kIdle:
+          if (slot.state.compare_exchange_weak(state, State::kQueued,
+                                               std::memory_order_acq_rel)) {
+            Inject(slot);
+            return;
+          }
+          break;
+
+        case State::kRunning:
+          if (slot.state.compare_exchange_weak(state, State::kNotified,
+                                               std::memory_order_acq_rel)) {
+            return;
+          }
+          break;
+
+        default:
+          return;
+      }
+    }
+  }
+
+  void Inject(Slot &slot) {
+    {
+      std::lock_guard lock{mutex_};
+      inject_.push_back(&slot);
+    }
+    cv_.notify_one();
+  }
+
+  void PushLocal(Worker &worker, Slot &slot) {
+    {
+      std::lock_guard lock{worker.mutex};
+      worker.deque.push_back(&slot);
+    }
+
+    if (sleeping_.load(std::memory_order_acquire) != 0) {
+      cv_.notify_one();
+    }
+  }
+
+  auto PopLocal(Worker &worker) -> Slot * {
+    std::lock_guard lock{worker.mutex};
+    if (worker.deque.empty()) {
+      return nullptr;
+    }
+
+    auto slot = worker.deque.back();
+    worker.deque.pop_back();
+    return slot;
+  }
+
+  auto Steal(std::size_t self) -> Slot * {
+    for (std::size_t i = 1; i < workers_.size(); i++) {
+      auto &victim = *workers_[(self + i) % workers_.size()];
+
+      std::lock_guard lock{victim.mutex};
+      if (!victim.deque.empty()) {
+        auto slot = victim.deque.front();
+        victim.deque.pop_front();
+        workers_[self]->steals.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+      }
+    }
+
+    return nullptr;
+  }
+
+  /// @brief 期限に達した Loop を inject_ へ移す (mutex_ を保持して呼ぶ)
+  void MoveDueTimers() {
+    auto now = Clock::now();
+
+    while (!timers_.empty() && timers_.front().deadline <= now) {
+      std::pop_heap(timers_.begin(), timers_.end());
+      auto slot = timers_.back().slot;
+      timers_.pop_back();
+
+      // 既に積まれている (もしくは実行中の) 場合は古いエントリなので捨てる
+      auto expected = State::kIdle;
+      if (slot->state.compare_exchange_strong(expected, State::kQueued,
+                                              std::memory_order_acq_rel)) {
+        inject_.push_back(slot);
+      }
+    }
+  }
+
+  auto PopInject() -> Slot * {
+    std::lock_guard lock{mutex_};
+    MoveDueTimers();
+
+    if (inject_.empty()) {
+      return nullptr;
+    }
+
+    auto slot = inject_.front();
+    inject_.pop_front();
+    return slot;
+  }
+
+  /// @brief 仕事が来るまで眠る
+  void WaitForWork(Worker &worker) {
+    std::unique_lock lock{mutex_};
+    MoveDueTimers();
+    if (!inject_.empty() || !running_.load(std::memory_order_acquire)) {
+      return;
+    }
+
+    worker.sleeps.fetch_add(1, std::memory_order_relaxed);
+    sleeping_.fetch_add(1, std::memory_order_acq_rel);
+
+    if (timers_.empty()) {
+      cv_.wait(lock);
+    } else {
+      auto grace = timers_.front().deadline - Clock::now();
+      cv_.wait_for(lock,
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(grace));
+    }
+
+    sleeping_.fetch_sub(1, std::memory_order_acq_rel);
+  }
+
+  /// @brief Loop を 1 周実行し，次に実行すべき時に備えて積み直す
+  void RunSlot(Worker &worker, Slot &slot) {
+    slot.state.store(State::kRunning, std::memory_order_release);
+
+    slot.loop->Poll();
+    worker.polls.fetch_add(1, std::memory_order_relaxed);
+
+    auto deadline = slot.loop->NextDeadline();
+    if (slot.loop->HasPendingWork() ||
+        (deadline.has_value() && *deadline <= Clock::now())) {
+      slot.state.store(State::kQueued, std::memory_order_release);
+      PushLocal(worker, slot);
+      return;
+    }
+
+    auto expected = State::kRunning;
+    if (!slot.state.compare_exchange_strong(expected, State::kIdle,
+                                            std::memory_order_acq_rel)) {
+      // 実行中に Wake() された
+      slot.state.store(State::kQueued, std::memory_order_release);
+      PushLocal(worker, slot);
+      return;
+    }
+
+    // kIdle にしてから登録する (先に登録すると，期限に達した時に
+    // kRunning のままなので捨てられてしまう)
+    if (!deadline.has_value()) {
+      return;
+    }
+
+    {
+      std::lock_guard lock{mutex_};
+      timers_.push_back(TimerEntry{*deadline, &slot});
+      std::push_heap(timers_.begin(), timers_.end());
+    }
+
+    // 眠っているワーカーがより遅い期限を待っているかもしれない
+    if (sleeping_.load(std::memory_order_acquire) != 0) {
+      cv_.notify_one();
+    }
+  }
+
+  void WorkerMain(std::size_t index) {
+    auto &worker = *workers_[index];
+
+    while (running_.load(std::memory_order_acquire)) {
+      auto slot = PopLocal(worker);
+      if (slot == nullptr) {
+        slot = PopInject();
+      }
+      if (slot == nullptr) {
+        slot = Steal(index);
+      }
+
+      if (slot == nullptr) {
+        WaitForWork(worker);
+        continue;
+      }
+
+      RunSlot(worker, *slot);
+    }
+  }
+
+ public:
+  /// @param workers ワーカースレッドの数 (0 の場合は CPU のコア数)
+  explicit Executor(std::size_t workers = 0)
+      : worker_count_(workers != 0
+                          ? workers
+                          : std::max(1u, std::thread::hardware_concurrency())) {
+  }
+
+  Executor(Executor const &) = delete;
+  Executor &operator=(Executor const &) = delete;
+
+  ~Executor() { Stop(); }
+
+  /// @brief Loop を登録する (Start() の前に呼ぶこと)
+  /// @details 登録した Loop は Executor より長く生存すること．
+  ///  Loop::Run() など，他の方法で同時に実行してはならない
+  void Add(Loop<Clock> &loop) {
+    auto slot = std::make_unique<Slot>();
+    slot->executor = this;
+    slot->loop = &loop;
+    loop.SetWakeHandler(&Executor::OnWake, slot.get());
+
+    inject_.push_back(slot.get());
+    slots_.emplace_back(std::move(slot));
+  }
+
+  /// @brief ワーカースレッドを起動する
+  void Start() {
+    if (running_.exchange(true)) {
+      return;
+    }
+
+    for (std::size_t i = 0; i < worker_count_; i++) {
+      workers_.emplace_back(std::make_unique<Worker>());
+    }
+
+    for (std::size_t i = 0; i < worker_count_; i++) {
+      workers_[i]->thread = std::thread([this, i] { WorkerMain(i); });
+    }
+  }
+
+  /// @brief ワーカースレッドを止めて終了を待つ
+  /// @details 実行中の Poll() は最後まで実行される
+  void Stop() {
+    {
+      std::lock_guard lock{mutex_};
+      if (!running_.exchange(false)) {
+        return;
+      }
+    }
+    cv_.notify_all();
+
+    for (auto &worker : workers_) {
+      worker->thread.join();
+    }
+
+    // 積まれたままの Loop は次の Start() で再開する
+    for (auto &worker : workers_) {
+      inject_.insert(inject_.end(), worker->deque.begin(), worker->deque.end());
+      Accumulate(stopped_stats_, *worker);
+    }
+    workers_.clear();
+  }
+
+  /// @brief 指定時間だけ実行する
+  void RunFor(typename Clock::duration duration) {
+    Start();
+    std::this_thread::sleep_for(duration);
+    Stop();
+  }
+
+  auto WorkerCount() const -> std::size_t { return worker_count_; }
+
+  /// @brief 統計情報 (Stop() したワーカーの分も含む)
+  auto GetStats() const -> Stats {
+    auto stats = stopped_stats_;
+    for (auto const &worker : workers_) {
+      Accumulate(stats, *worker);
+    }
+
+    return stats;
+  }
+};
+}  // namespace robobus::runtime
+
+#endif
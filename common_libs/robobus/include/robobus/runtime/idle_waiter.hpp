@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+#include <chrono>
+
+#if defined(__MBED__)
+#include <rtos/EventFlags.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace robobus::runtime {
+/// @brief Loop がアイドル時に眠るための待機オブジェクト
+/// @details 指定時間が経過するか，Notify() が呼ばれるまで呼び出し元を眠らせる．
+///  Notify() は Wait 前に呼ばれていても取りこぼさない．
+///  Mbed では EventFlags を用いるため，Notify() は割り込みからも呼び出せる．
+///  Mbed の待ち時間はカーネルの tick (1ms) 単位で切り上げるので，
+///  期限より最大 1 tick 遅れて起きる (1ms 未満の待ちでも眠る)
+class IdleWaiter {
+#if defined(__MBED__)
+  static constexpr std::uint32_t kWakeFlag = 1;
+
+  rtos::EventFlags flags_;
+
+ public:
+  /// @return Notify() により起こされた場合 true
+  template <typename Rep, typename Period>
+  auto WaitFor(std::chrono::duration<Rep, Period> timeout) -> bool {
+    using namespace std::chrono;
+    // 切り捨てると 1ms 未満の残り時間で待たずに戻り，Loop が期限まで空回りする
+    auto timeout_ms = ceil<milliseconds>(timeout);
+    if (timeout_ms <= milliseconds::zero()) {
+      return false;
+    }
+
+    auto result = flags_.wait_any_for(
+        kWakeFlag, rtos::Kernel::Clock::duration_u32(timeout_ms.count()));
+
+    return (result & osFlagsError) == 0;
+  }
+
+  void Wait() { flags_.wait_any(kWakeFlag); }
+
+  void Notify() { flags_.set(kWakeFlag); }
+#else
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool notified_ = false;
+
+ public:
+  /// @return Notify() により起こされた場合 true
+  template <typename Rep, typename Period>
+  auto WaitFor(std::chrono::duration<Rep, Period> timeout) -> bool {
+    using namespace std::chrono;
+
+    std::unique_lock lock{mutex_};
+    cv_.wait_for(lock, duration_cast<nanoseconds>(timeout),
+                 [this] { return notified_; });
+
+    auto notified = notified_;
+    notified_ = false;
+    return notified;
+  }
+
+  void Wait() {
+    std::unique_lock lock{mutex_};
+    cv_.wait(lock, [this] { return notified_; });
+    notified_ = false;
+  }
+
+  void Notify() {
+    {
+      std::lock_guard lock{mutex_};
+      notified_ = true;
+    }
+    cv_.notify_one();
+  }
+#endif
+};
+}  // namespace robobus::runtime
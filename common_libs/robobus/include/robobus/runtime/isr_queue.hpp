@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+
+#include "../../internal/mpsc_queue.hpp"
+#include "loop.hpp"
+
+namespace robobus::runtime {
+/// @brief 割り込み (もしくは他スレッド) から Loop 上のコルーチンへイベントを渡すキュー
+/// @details Post() は値をロックフリーのキューに積み，待っているタスクがいれば
+///  Loop::ScheduleFromIsr() するだけなので，割り込み内の処理は数命令で済む．
+///  取り出す側は Loop 上の 1 つのコルーチンで `co_await queue.Next()` する
+/// @tparam Clock Loop の Clock
+/// @tparam T イベントの型 (trivially copyable)
+/// @tparam Capacity キューの長さ (2 の冪)
+template <typename Clock, typename T, std::size_t Capacity>
+  requires std::chrono::is_clock_v<Clock>
+class IsrQueue {
+  Loop<Clock> &loop_;
+  internal::MpscQueue<T, Capacity> queue_;
+
+  /// Next() で待っているタスク (Post() 側が取り出して起こす)
+  std::atomic<TaskNode *> waiter_{nullptr};
+  std::atomic<std::uint32_t> dropped_{0};
+
+  class Awaiter {
+    IsrQueue &queue_;
+    T value_;
+    bool has_value_ = false;
+    bool suspended_ = false;
+
+   public:
+    explicit Awaiter(IsrQueue &queue) : queue_(queue) {}
+
+    Awaiter(Awaiter const &) = delete;
+    Awaiter &operator=(Awaiter const &) = delete;
+
+    bool await_ready() {
+      has_value_ = queue_.queue_.TryPop(value_);
+      return has_value_;
+    }
+
+    template <TaskPromise Promise>
+    bool await_suspend(std::coroutine_handle<Promise> handle) {
+      queue_.waiter_.exchange(&handle.promise(), std::memory_order_acq_rel);
+
+      // 登録前に Post() された値を見逃さないよう確認する．
+      // Post() 側が先に登録を取り出していれば，そちらが起こしてくれる
+      suspended_ =
+          queue_.queue_.Empty() ||
+          queue_.waiter_.exchange(nullptr, std::memory_order_acq_rel) ==
+              nullptr;
+
+      if (suspended_) {
+        queue_.loop_.RetainRemoteWaiter();
+      }
+
+      return suspended_;
+    }
+
+    auto await_resume() -> T {
+      if (suspended_) {
+        queue_.loop_.ReleaseRemoteWaiter();
+        suspended_ = false;
+      }
+
+      if (!has_value_) {
+        queue_.queue_.TryPop(value_);
+      }
+
+      return value_;
+    }
+  };
+
+ public:
+  explicit IsrQueue(Loop<Clock> &loop) : loop_(loop) {}
+
+  IsrQueue(IsrQueue const &) = delete;
+  IsrQueue &operator=(IsrQueue const &) = delete;
+
+  /// @brief イベントを積む (割り込みから呼び出せる)
+  /// @return キューが満杯で捨てた場合 false
+  auto Post(T const &value) -> bool {
+    if (!queue_.TryPush(value)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    if (auto waiter = waiter_.exchange(nullptr, std::memory_order_acq_rel)) {
+      loop_.ScheduleFromIsr(*waiter);
+    }
+
+    return true;
+  }
+
+  /// @brief 次のイベントを待つ
+  /// @details 待てるのは同時に 1 つのコルーチンのみ．
+  ///  待っている間にコルーチンを破棄してはならない
+  auto Next() { return Awaiter{*this}; }
+
+  /// @brief 待たずにイベントを取り出す (Loop 上からのみ)
+  /// @return 空の場合 false
+  auto TryPop(T &out) -> bool { return queue_.TryPop(out); }
+
+  /// @brief キューが満杯で捨てたイベントの数
+  auto Dropped() const -> std::uint32_t {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+};
+}  // namespace robobus::runtime
@@ -1,95 +1,534 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <coroutine>
 #include <chrono>
-#include <list>
+#include <optional>
+#include <vector>
+
+#if defined(__MBED__)
+#include <cmsis_os2.h>
+#include <platform/mbed_critical.h>
+#else
+#include <thread>
+#endif
 
 #include <logger/logger.hpp>
 #include <robotics/thread/thread.hpp>
 
+#include "../../internal/intrusive_mpsc_queue.hpp"
+#include "idle_waiter.hpp"
+#include "task_node.hpp"
 #include "time_context.hpp"
+#include "timer_queue.hpp"
+#include "virtual_clock.hpp"
+
+/// @def ROBOBUS_LOOP_TRACE
+/// @brief 1 を定義するとタスクの再開とタイマーの登録ごとに Trace を出す
+/// @details 再開のたびに書式化が走るので，既定では呼び出しごと取り除く
+#ifndef ROBOBUS_LOOP_TRACE
+#define ROBOBUS_LOOP_TRACE 0
+#endif
 
 namespace robobus::runtime {
+/// @brief 実行可能なコルーチンが無い時の Loop の振る舞い
+enum class IdleMode {
+  /// 次の期限まで CPU を回し続ける (最小のジッタ)
+  kBusy,
+  /// 次の期限まで (もしくは Wake() まで) 眠る．
+  /// Mbed ではカーネルの tick 単位で眠るため，期限より最大 1 tick 遅れる
+  kTickless,
+};
+
 /// @brief コルーチンベースプログラムで用いるコンテキスト
 template <typename Clock>
   requires std::chrono::is_clock_v<Clock>
 class Loop {
   static inline robotics::logger::Logger logger{"loop.robobus", "Loop "};
-  std::list<std::coroutine_handle<>> coroutines_;
+  internal::IntrusiveList<TaskNode, TaskListTag> tasks_;
+  using ReadyQueue = internal::IntrusiveList<TaskNode, ReadyQueueTag>;
+  using ReadyQueues = std::array<ReadyQueue, kPriorityClasses>;
+
+  /// 優先度クラスごとの実行可能キュー
+  ReadyQueues ready_;
+  std::array<PriorityStats, kPriorityClasses> priority_stats_{};
+
+  TimerQueue<typename Clock::time_point, TaskNode *> timers_;
+
+  /// 割り込み・他スレッドから ScheduleFromIsr() されたタスク (TaskNode に埋め込んだフックで連結する)
+  internal::IntrusiveMpscQueue<TaskNode, RemoteQueueTag> remote_;
+  /// ScheduleFromIsr() で起こされるのを待っているタスクの数
+  std::size_t remote_waiters_ = 0;
+
+#if ROBOBUS_ENABLE_PROFILING
+ public:
+  /// @brief AddTask() していないタスク (co_await した子のコルーチン) の計測値
+  /// @details 子は親より先に終わるので，所属 Context ごとに Loop が合算して持つ
+  struct NestedProfile {
+    TaskProfile profile;
+    /// 計測結果の送り先の番号 (初めて送る時に登録する)
+    context::ContextID report_id = context::kNoContext;
+  };
+
+ private:
+  /// 所属 Context の番号 + 1 → 計測値 (先頭は所属の無いもの)
+  std::vector<NestedProfile> nested_profiles_;
+
+  auto NestedProfileOf(context::ContextID owner) -> TaskProfile & {
+    std::size_t index = owner == context::kNoContext ? 0 : owner + 1;
+    if (nested_profiles_.size() <= index) {
+      nested_profiles_.resize(index + 1);
+    }
+
+    return nested_profiles_[index].profile;
+  }
+
+  /// @brief task の計測値を記録する先 (AddTask() したものは自身，それ以外は所属 Context)
+  auto ProfileOf(TaskNode &task) -> TaskProfile & {
+    if (task.internal::IntrusiveListHook<TaskListTag>::IsLinked()) {
+      return task.Profile();
+    }
+
+    return NestedProfileOf(task.Owner());
+  }
+#endif
+
+  IdleWaiter idle_waiter_;
+  /// Wake() の通知先 (Executor が設定する．未設定ならば idle_waiter_ を起こす)
+  void (*wake_handler_)(void *) = nullptr;
+  void *wake_context_ = nullptr;
+  IdleMode idle_mode_ = IdleMode::kTickless;
+  typename Clock::duration idle_time_ = Clock::duration::zero();
+  typename Clock::time_point stats_begin_ = Clock::now();
 
-  std::list<std::pair<typename Clock::time_point, std::coroutine_handle<>>>
-      resume_list_;
+  /// 最後に Poll() したスレッド (まだ Poll() していなければ既定値)
+#if defined(__MBED__)
+  std::atomic<osThreadId_t> poll_thread_{nullptr};
+#else
+  std::atomic<std::thread::id> poll_thread_{};
+#endif
 
  public:
   TimeContext<Clock> time;
 
  private:
   void ProcessResumeList() {
-    auto minimum_grace = Clock::duration::max();
-    const auto now = time.Now();
+    timers_.PopDue(time.Now(), [this](TaskNode *task, auto deadline) {
+#if ROBOBUS_ENABLE_PROFILING
+      auto lateness = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          time.Now() - deadline);
+      ProfileOf(*task).RecordLateness(lateness.count());
+#endif
+
+      Schedule(*task);
+    });
+  }
+
+  static void Enqueue(ReadyQueues &queues, TaskNode &task) {
+    if (task.IsReady()) {
+      return;
+    }
+
+    queues[PriorityIndex(task.GetPriority())].PushBack(task);
+  }
 
-    for (auto &&[c_time, coro] : resume_list_) {
-      auto grace = c_time - now;
+  void ProcessRemoteQueue(ReadyQueues &queues) {
+    remote_.Drain([&queues](TaskNode &task) { Enqueue(queues, task); });
+  }
 
-      if (0 < grace.count() && grace < minimum_grace) {
-        minimum_grace = grace;
+  /// @return 最も優先度の高い実行可能なタスク
+  static auto PopHighest(ReadyQueues &queues, std::size_t &index)
+      -> TaskNode * {
+    for (index = 0; index < kPriorityClasses; index++) {
+      if (auto task = queues[index].PopFront()) {
+        return task;
       }
+    }
 
-      if (c_time <= now) {
-        logger.Info("Resume at %p (requested as resume in %d)", coro.address(),
-                    c_time.time_since_epoch().count());
-        coro.resume();
+    return nullptr;
+  }
 
-        continue;
+  /// @brief 実行可能キューのタスクを優先度の高い順に再開する
+  /// @details 再開中に実行可能になったタスクは次の周で再開する．
+  ///  ただし割り込みから実行可能にされたタスクは，より低いクラスのタスクより先に
+  ///  (次の中断点で) 再開する
+  void ProcessReadyQueue() {
+    ReadyQueues batch;
+    for (std::size_t i = 0; i < kPriorityClasses; i++) {
+      batch[i].Splice(ready_[i]);
+    }
+
+    std::size_t index;
+    while (auto task = PopHighest(batch, index)) {
+      priority_stats_[index].resumes++;
+      for (auto lower = index + 1; lower < kPriorityClasses; lower++) {
+        if (!batch[lower].Empty()) {
+          priority_stats_[lower].deferred++;
+        }
+      }
+
+#if ROBOBUS_LOOP_TRACE
+      logger.Trace("Resume at %p", task->Handle().address());
+#endif
+
+      // 再開中に作られた子のコルーチンはこのタスクの優先度と所属を引き継ぐ
+      PriorityScope priority(task->GetPriority());
+      OwnerScope owner(task->Owner());
+
+#if ROBOBUS_ENABLE_PROFILING
+      // 再開中にコルーチンが終了すると TaskNode も破棄されるので見張る
+      TaskNode *running = task;
+      task->Watch(&running);
+      auto is_root = task->internal::IntrusiveListHook<TaskListTag>::IsLinked();
+      auto task_owner = task->Owner();
+
+      auto begin = CycleCounter::Now();
+      task->Handle().resume();
+      auto cycles = static_cast<CycleCounter::Cycles>(CycleCounter::Now() - begin);
+
+      if (running != nullptr) {
+        running->Watch(nullptr);
+      }
+      if (!is_root) {
+        // 子は終了していても所属 Context に数える
+        NestedProfileOf(task_owner).RecordRun(cycles);
+      } else if (running != nullptr) {
+        running->Profile().RecordRun(cycles);
+      }
+#else
+      task->Handle().resume();
+#endif
+
+      if (!remote_.Empty()) {
+        PreemptByRemote(batch);
       }
     }
+  }
+
+  /// @brief 割り込みから実行可能にされたタスクを今回の周に割り込ませる
+  void PreemptByRemote(ReadyQueues &batch) {
+    auto highest = kPriorityClasses;
 
-    resume_list_.remove_if(
-        [this, now](auto const &pair) { return pair.first <= now; });
+    remote_.Drain([&batch, &highest](TaskNode &task) {
+      if (task.IsReady()) {
+        return;
+      }
+
+      auto index = PriorityIndex(task.GetPriority());
+      if (index < highest) {
+        highest = index;
+      }
+
+      batch[index].PushBack(task);
+    });
 
-    if (minimum_grace != Clock::duration::max() &&
-        minimum_grace > std::chrono::milliseconds(100)) {
-      logger.Debug("Sleeping for %d", minimum_grace.count());
-      robotics::system::SleepFor(
-          std::chrono::duration_cast<std::chrono::milliseconds>(minimum_grace));
+    for (auto lower = highest + 1; lower < kPriorityClasses; lower++) {
+      if (!batch[lower].Empty()) {
+        priority_stats_[lower].preempted++;
+      }
     }
   }
 
+  /// @brief 次の期限 (limit が先ならば limit) まで，もしくは Wake() されるまで眠る
+  /// @details AdvanceableClock の場合は眠らずに時計を進める
+  void Idle(typename Clock::time_point limit = Clock::time_point::max()) {
+    if (HasReadyTask() || !remote_.Empty()) {
+      return;
+    }
+
+    auto until = limit;
+    if (!timers_.Empty() && timers_.NextDeadline() < until) {
+      until = timers_.NextDeadline();
+    }
+
+    const auto begin = Clock::now();
+
+    if constexpr (AdvanceableClock<Clock>) {
+      if (until != Clock::time_point::max()) {
+        Clock::AdvanceTo(until);
+      }
+    } else {
+      if (idle_mode_ == IdleMode::kBusy) {
+        return;
+      }
+
+      if (until == Clock::time_point::max()) {
+        logger.Debug("Sleeping until woken up");
+        idle_waiter_.Wait();
+      } else {
+        auto grace = until - begin;
+        if (grace <= Clock::duration::zero()) {
+          return;
+        }
+
+        logger.Debug("Sleeping for %d", grace.count());
+        idle_waiter_.WaitFor(grace);
+      }
+    }
+
+    idle_time_ += Clock::now() - begin;
+  }
+
  public:
   Loop(Loop const &) = delete;
   Loop &operator=(Loop const &) = delete;
 
-  Loop() = default;
+  Loop() {
+#if ROBOBUS_ENABLE_PROFILING
+    CycleCounter::Init();
+#endif
+  }
 
   //* Loop traits
-  void AddTask(std::coroutine_handle<> coroutine) {
-    coroutines_.push_back(coroutine);
+  /// @brief タスクを Loop の管理下に置く
+  /// @details TaskNode は Promise に埋め込まれているためメモリ確保は発生しない．
+  ///  コルーチンが終了すると自動で管理下から外れる
+  template <TaskPromise Promise>
+  void AddTask(std::coroutine_handle<Promise> coroutine) {
+    tasks_.PushBack(coroutine.promise());
+  }
+
+  /// @brief 優先度クラスを指定してタスクを Loop の管理下に置く
+  /// @details Coroutine は作られた時点で最初の中断点まで実行済みなので，
+  ///  その間に作られた子には priority が伝わらない．最初から効かせるには Start() を使う
+  template <TaskPromise Promise>
+  void AddTask(std::coroutine_handle<Promise> coroutine, Priority priority) {
+    coroutine.promise().SetPriority(priority);
+    AddTask(coroutine);
+  }
+
+  /// @brief 優先度クラスを指定してコルーチンを作り，Loop の管理下に置く
+  /// @details start() の呼び出し (コルーチンの最初の実行) から priority が効き，
+  ///  その中で co_await した子のコルーチンにも引き継がれる
+  /// @param start コルーチンを返す関数 (例: `[&] { return Main(); }`)
+  /// @return start() が返したコルーチン
+  template <typename F>
+  auto Start(Priority priority, F &&start) {
+    PriorityScope scope(priority);
+    auto coroutine = start();
+    AddTask(coroutine.handle);
+
+    return coroutine;
+  }
+
+  /// @brief 管理下のタスクを列挙する
+  template <typename F>
+  void ForEachTask(F &&f) {
+    tasks_.ForEach([&f](TaskNode &task) { f(task); });
+  }
+
+#if ROBOBUS_ENABLE_PROFILING
+  /// @brief co_await した子のコルーチンの計測値を所属 Context ごとに列挙する
+  /// @details f は (所属 Context の番号, NestedProfile &) で呼ばれる．
+  ///  一度も再開されていない所属は飛ばす
+  template <typename F>
+  void ForEachNestedProfile(F &&f) {
+    for (std::size_t i = 0; i < nested_profiles_.size(); i++) {
+      auto &nested = nested_profiles_[i];
+      if (nested.profile.resumes == 0 && nested.profile.timer_wakes == 0) {
+        continue;
+      }
+
+      f(i == 0 ? context::kNoContext : static_cast<context::ContextID>(i - 1),
+        nested);
+    }
+  }
+#endif
+
+  /// @brief 遅延開始のコルーチン (Task::Detach() したもの) をタスクとして開始する
+  /// @details 次の Poll() で最初に再開される
+  template <TaskPromise Promise>
+  void Spawn(std::coroutine_handle<Promise> coroutine,
+             Priority priority = Priority::kComms) {
+    AddTask(coroutine, priority);
+    Schedule(coroutine.promise());
+  }
+
+  /// @brief タスクを実行可能キューに入れる (既に入っている場合は何もしない)
+  void Schedule(TaskNode &task) { Enqueue(ready_, task); }
+
+  auto HasReadyTask() const -> bool {
+    for (auto const &queue : ready_) {
+      if (!queue.Empty()) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /// @brief 割り込み・他スレッドからタスクを実行可能にする
+  /// @details TaskNode に埋め込んだフックでロックフリーのキューに積み，Loop を起こすだけなので
+  ///  割り込みから呼び出せる．キューに容量の制限は無く失敗しない．
+  ///  実際に実行可能キューへ入れるのは次の Poll()．
+  ///  Poll() までに同じタスクを何度積んでも 1 回の再開にまとまる．
+  ///  積んだタスクを Poll() までに破棄してはならない
+  void ScheduleFromIsr(TaskNode &task) {
+    if (remote_.Push(task)) {
+      Wake();
+    }
   }
 
-  void RequestResumeAt(typename Clock::time_point time_point,
-                       std::coroutine_handle<> coroutine) {
+  /// @brief ScheduleFromIsr() で積まれたまま再開された task を，再び再開されないようにする
+  /// @details 別の経路 (タイマーなど) で先に再開されたタスクから呼ぶ．
+  ///  積まれていれば積まれているタスクをまとめて実行可能キューへ移し，task だけ外す
+  void ForgetRemote(TaskNode &task) {
+    if (!task.internal::IntrusiveMpscHook<RemoteQueueTag>::IsQueued()) {
+      return;
+    }
+
+    ProcessRemoteQueue(ready_);
+    task.internal::IntrusiveListHook<ReadyQueueTag>::Unlink();
+  }
+
+  /// @brief ScheduleFromIsr() で起こされるのを待つタスクの数を増やす
+  /// @details 待っている間は RunUntil() が早期に終了しなくなる
+  void RetainRemoteWaiter() { remote_waiters_++; }
+
+  void ReleaseRemoteWaiter() { remote_waiters_--; }
+
+  /// @brief 指定時刻にタスクを実行可能キューへ入れる
+  /// @return 取り消しに用いる識別子
+  auto RequestResumeAt(typename Clock::time_point time_point, TaskNode &task)
+      -> TimerId {
+#if ROBOBUS_LOOP_TRACE
     auto now = time.Now().time_since_epoch();
     auto delta = time_point - time.Started();
 
-    logger.Info("Requested resume at %p in %d (now %d)", coroutine.address(),
-                delta.count(), now.count());
-    resume_list_.push_back({time_point, coroutine});
+    logger.Trace("Requested resume at %p in %d (now %d)",
+                 task.Handle().address(), delta.count(), now.count());
+#endif
+    return timers_.Push(time_point, &task);
+  }
+
+  /// @brief RequestResumeAt() を取り消す (O(1))
+  /// @return 取り消せた場合 true (既に期限に達していた場合 false)
+  auto CancelResume(TimerId id) -> bool { return timers_.Cancel(id); }
+
+  /// @brief 期限待ちのタイマーの数
+  auto PendingTimers() const -> std::size_t { return timers_.Size(); }
+
+  /// @brief タイマーキューの領域を事前に確保する
+  /// @param capacity 同時に Sleep するコルーチンの最大数の見込み
+  void ReserveTimers(std::size_t capacity) { timers_.Reserve(capacity); }
+
+  void SetIdleMode(IdleMode mode) { idle_mode_ = mode; }
+
+  /// @brief アイドル中の Loop を起こす
+  /// @details 他スレッド (Mbed では割り込み) から呼び出せる
+  void Wake() {
+    if (wake_handler_ != nullptr) {
+      wake_handler_(wake_context_);
+      return;
+    }
+
+    idle_waiter_.Notify();
+  }
+
+  /// @brief Wake() の通知先を差し替える (Loop を外部で駆動する Executor 用)
+  /// @details 他スレッドから Wake() される前に設定すること
+  void SetWakeHandler(void (*handler)(void *), void *context) {
+    wake_handler_ = handler;
+    wake_context_ = context;
+  }
+
+  /// @brief Loop を駆動するスレッドから呼ばれているか
+  /// @details 割り込みの中や，最後に Poll() したのと別のスレッドからは false．
+  ///  まだ Poll() していなければ (割り込み以外は) true
+  auto InLoopContext() const -> bool {
+#if defined(__MBED__)
+    if (core_util_is_isr_active()) {
+      return false;
+    }
+    auto thread = poll_thread_.load(std::memory_order_relaxed);
+    return thread == nullptr || thread == osThreadGetId();
+#else
+    auto thread = poll_thread_.load(std::memory_order_relaxed);
+    return thread == std::thread::id{} || thread == std::this_thread::get_id();
+#endif
+  }
+
+  /// @brief 次の Poll() で再開できるタスクがあるか (Loop を駆動するスレッドから)
+  auto HasPendingWork() const -> bool {
+    return HasReadyTask() || !remote_.Empty();
+  }
+
+  /// @brief 最も早いタイマーの期限
+  auto NextDeadline() const -> std::optional<typename Clock::time_point> {
+    if (timers_.Empty()) {
+      return std::nullopt;
+    }
+
+    return timers_.NextDeadline();
+  }
+
+  auto GetPriorityStats(Priority priority) const -> PriorityStats const & {
+    return priority_stats_[PriorityIndex(priority)];
+  }
+
+  void ResetPriorityStats() { priority_stats_ = {}; }
+
+  /// @brief 前回の ResetIdleStats() 以降に眠っていた時間の割合 [%]
+  auto IdlePercentage() const -> float {
+    using Seconds = std::chrono::duration<float>;
+
+    auto total = Seconds(Clock::now() - stats_begin_).count();
+    if (total <= 0) {
+      return 0;
+    }
+
+    return 100 * Seconds(idle_time_).count() / total;
+  }
+
+  void ResetIdleStats() {
+    idle_time_ = Clock::duration::zero();
+    stats_begin_ = Clock::now();
   }
 
   //* Root context
+  /// @brief メインループを 1 周だけ実行する (眠らない)
+  void Poll() {
+#if defined(__MBED__)
+    poll_thread_.store(osThreadGetId(), std::memory_order_relaxed);
+#else
+    poll_thread_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+#endif
+    time.Tick();
+    ProcessResumeList();
+    ProcessRemoteQueue(ready_);
+    ProcessReadyQueue();
+  }
+
+  /// @brief 指定時刻まで Loop を実行する
+  /// @return 待っているタスクが無くなり，時刻に達する前に終了した場合 false
+  auto RunUntil(typename Clock::time_point deadline) -> bool {
+    while (true) {
+      Poll();
+
+      if (deadline <= time.Now()) {
+        return true;
+      }
+
+      if (!HasReadyTask() && timers_.Empty() && remote_waiters_ == 0) {
+        return false;
+      }
+
+      Idle(deadline);
+    }
+  }
+
+  /// @brief 指定時間だけ Loop を実行する
+  auto RunFor(typename Clock::duration duration) -> bool {
+    return RunUntil(Clock::now() + duration);
+  }
+
   [[noreturn]]
   void Run() {
     logger.Trace("Starting main loop");
     while (true) {
-      for (auto const &coroutine : coroutines_) {
-        if (coroutine.done()) {
-          logger.Info("Remove the %p", coroutine.address());
-          coroutines_.remove(coroutine);
-        }
-      }
-
-      time.Tick();
-      ProcessResumeList();
+      Poll();
+      Idle();
     }
   }
 
@@ -102,9 +541,15 @@ class Loop {
     thread.SetThreadName("Loop-Debug");
     thread.Start([this]() {
       while (true) {
-        logger.Info("Elapsed: %d, Now: %d, resume_list: %d entries",
+        logger.Info("Elapsed: %d, Now: %d, timers: %d entries, idle: %.1f%%",
                     time.ElapsedTime().count(),
-                    time.Now().time_since_epoch().count(), resume_list_.size());
+                    time.Now().time_since_epoch().count(), timers_.Size(),
+                    IdlePercentage());
+        logger.Info(
+            "Deferred: comms %d, diagnostics %d",
+            static_cast<int>(GetPriorityStats(Priority::kComms).deferred),
+            static_cast<int>(
+                GetPriorityStats(Priority::kDiagnostics).deferred));
 
         robotics::system::SleepFor(1s);
       }
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace robobus::runtime {
+/// @brief タスクの優先度クラス
+/// @details Loop は実行可能なタスクを優先度の高いクラスから順に再開する
+enum class Priority : std::uint8_t {
+  /// モーター制御など，遅れが許されないもの
+  kControl = 0,
+  /// 通信処理 (既定)
+  kComms = 1,
+  /// ログ・テレメトリなど，遅れてもよいもの
+  kDiagnostics = 2,
+};
+
+constexpr std::size_t kPriorityClasses = 3;
+
+constexpr auto PriorityIndex(Priority priority) -> std::size_t {
+  return static_cast<std::size_t>(priority);
+}
+
+/// @brief 優先度クラスごとの統計情報
+struct PriorityStats {
+  /// 再開された回数
+  std::uint64_t resumes = 0;
+  /// 実行可能なのに上位クラスのタスクが先に再開された回数 (飢餓の目安)
+  std::uint64_t deferred = 0;
+  /// 割り込みで実行可能になった上位クラスのタスクに追い越された回数
+  std::uint64_t preempted = 0;
+};
+}  // namespace robobus::runtime
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#if defined(__MBED__)
+#include <platform/mbed_critical.h>
+#endif
+
+#include "../../internal/signal.hpp"
+#include "loop.hpp"
+
+namespace robobus::runtime {
+/// @brief Signal の次の Fire を待つための awaiter
+/// @details Fire されると Loop の実行可能キューを通じて再開する．
+///  タイムアウトを指定した場合，期限までに Fire されなければ std::nullopt を返す．
+///  割り込み (CAN の受信コールバックなど) や他スレッドから Fire された場合は，
+///  値を預かって Loop::ScheduleFromIsr() で起こし，タイマーの取り消しは
+///  再開後に Loop 上で行う．タイムアウトと同時に Fire された場合はどちらか一方だけが
+///  タスクを再開する．Mbed では待ち始め・待ち終わりの登録操作を割り込み禁止で守る．
+///  ホストの他スレッドから Fire する場合，Signal の待ち行列自体はロックされないので，
+///  待ち始め・待ち終わりと Fire が重ならないようにすること
+template <typename Clock, typename T>
+  requires std::chrono::is_clock_v<Clock>
+class SignalAwaiter : public internal::SignalWaiter<T> {
+  Loop<Clock> &loop_;
+  internal::SignalRx<T> rx_;
+  std::optional<typename Clock::duration> timeout_;
+
+  enum State : std::uint8_t {
+    kWaiting,
+    /// Loop の外からの Fire が値を書き込んでいる
+    kClaimed,
+    /// Loop の外からの Fire が ScheduleFromIsr() まで済ませた
+    kScheduled,
+    kDone,
+  };
+
+  TaskNode *task_ = nullptr;
+  TimerId timer_{};
+  std::optional<T> value_;
+  std::atomic<std::uint8_t> state_{kWaiting};
+
+#if defined(__MBED__)
+  struct CriticalSection {
+    CriticalSection() { core_util_critical_section_enter(); }
+    ~CriticalSection() { core_util_critical_section_exit(); }
+  };
+#else
+  struct CriticalSection {};
+#endif
+
+  /// @brief Loop の外から Fire された
+  void NotifyFromIsr(T const &data) {
+    std::uint8_t expected = kWaiting;
+    if (!state_.compare_exchange_strong(expected, kClaimed,
+                                        std::memory_order_acq_rel)) {
+      return;
+    }
+
+    value_.emplace(data);
+    loop_.ScheduleFromIsr(*task_);
+    state_.store(kScheduled, std::memory_order_release);
+  }
+
+ public:
+  SignalAwaiter(Loop<Clock> &loop, internal::SignalRx<T> rx,
+                std::optional<typename Clock::duration> timeout)
+      : loop_(loop), rx_(rx), timeout_(timeout) {}
+
+  SignalAwaiter(SignalAwaiter const &) = delete;
+  SignalAwaiter &operator=(SignalAwaiter const &) = delete;
+
+  ~SignalAwaiter() { loop_.CancelResume(timer_); }
+
+  void Notify(T const &data) override {
+    if (!loop_.InLoopContext()) {
+      NotifyFromIsr(data);
+      return;
+    }
+
+    value_.emplace(data);
+    state_.store(kDone, std::memory_order_relaxed);
+
+    loop_.CancelResume(timer_);
+    loop_.Schedule(*task_);
+  }
+
+  bool await_ready() const { return false; }
+
+  template <TaskPromise Promise>
+  bool await_suspend(std::coroutine_handle<Promise> handle) {
+    task_ = &handle.promise();
+
+    bool added;
+    {
+      CriticalSection critical;
+      added = rx_.AddWaiter(*this);
+    }
+    if (!added) {
+      // Signal が既に破棄されているので待たずに再開する
+      return false;
+    }
+
+    if (timeout_.has_value()) {
+      timer_ = loop_.RequestResumeAt(loop_.time.Now() + *timeout_, *task_);
+    }
+
+    return true;
+  }
+
+  /// @return Fire されたデータ (タイムアウトした場合 std::nullopt)
+  auto await_resume() -> std::optional<T> {
+    {
+      CriticalSection critical;
+      this->Unlink();
+    }
+    loop_.CancelResume(timer_);
+
+    std::uint8_t expected = kWaiting;
+    if (!state_.compare_exchange_strong(expected, kDone,
+                                        std::memory_order_acq_rel) &&
+        expected != kDone) {
+      // Loop の外からの Fire が先に取った．書き込みを待ち，
+      // タイマーで先に再開された場合は積まれた再開を取り消す
+      while (state_.load(std::memory_order_acquire) != kScheduled) {
+      }
+      loop_.ForgetRemote(*task_);
+    }
+
+    return std::move(value_);
+  }
+};
+
+/// @brief Signal の次の Fire を待つ
+/// @param loop 再開に用いる Loop
+/// @param rx 待つ Signal
+template <typename Clock, typename T>
+  requires std::chrono::is_clock_v<Clock>
+auto Next(Loop<Clock> &loop, internal::SignalRx<T> rx) {
+  return SignalAwaiter<Clock, T>(loop, rx, std::nullopt);
+}
+
+/// @brief Signal の次の Fire をタイムアウト付きで待つ
+/// @param loop 再開に用いる Loop
+/// @param rx 待つ Signal
+/// @param timeout タイムアウトまでの時間
+template <typename Clock, typename T>
+  requires std::chrono::is_clock_v<Clock>
+auto Next(Loop<Clock> &loop, internal::SignalRx<T> rx,
+          typename Clock::duration timeout) {
+  return SignalAwaiter<Clock, T>(loop, rx, timeout);
+}
+}  // namespace robobus::runtime
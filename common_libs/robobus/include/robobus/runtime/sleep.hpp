@@ -5,32 +5,92 @@
 
 #include <robotics/thread/thread.hpp>
 
+#include "cancellation.hpp"
 #include "loop.hpp"
 
 namespace robobus::runtime {
 /// @brief Sleep を行うための awaiter
+/// @details 待っている間にコルーチンが破棄された場合はタイマーも取り消す (O(1))
 template <typename Clock>
   requires std::chrono::is_clock_v<Clock>
 struct SleepAwaiter {
   Loop<Clock> &ctx;
   Clock::duration duration;
 
+ private:
+  TimerId timer_{};
+
+ public:
   explicit SleepAwaiter(Loop<Clock> &ctx, Clock::duration duration)
       : ctx(ctx), duration(duration) {}
 
+  SleepAwaiter(SleepAwaiter const &) = delete;
+  SleepAwaiter &operator=(SleepAwaiter const &) = delete;
+
+  ~SleepAwaiter() { ctx.CancelResume(timer_); }
+
   // Sleep が実行済かどうか
   // 今回は常に false を返す
   //  (Sleep した後は true
   //  になる．しかし，その時コルーチンは廃棄されているので)．
   bool await_ready() const { return false; }
 
-  void await_suspend(std::coroutine_handle<> handle) {
-    ctx.RequestResumeAt(ctx.time.Now() + duration, handle);
+  template <TaskPromise Promise>
+  void await_suspend(std::coroutine_handle<Promise> handle) {
+    timer_ = ctx.RequestResumeAt(ctx.time.Now() + duration, handle.promise());
   }
 
   void await_resume() const { return; }
 };
 
+/// @brief CancellationToken で途中で起こせる Sleep の awaiter
+template <typename Clock>
+  requires std::chrono::is_clock_v<Clock>
+class CancellableSleepAwaiter : private CancellationHook {
+  Loop<Clock> &ctx_;
+  typename Clock::duration duration_;
+  CancellationToken token_;
+
+  TaskNode *task_ = nullptr;
+  TimerId timer_{};
+  bool cancelled_ = false;
+
+  void OnCancel() override {
+    cancelled_ = true;
+    ctx_.CancelResume(timer_);
+    ctx_.Schedule(*task_);
+  }
+
+ public:
+  CancellableSleepAwaiter(Loop<Clock> &ctx, typename Clock::duration duration,
+                          CancellationToken token)
+      : ctx_(ctx), duration_(duration), token_(token) {}
+
+  CancellableSleepAwaiter(CancellableSleepAwaiter const &) = delete;
+  CancellableSleepAwaiter &operator=(CancellableSleepAwaiter const &) = delete;
+
+  ~CancellableSleepAwaiter() { ctx_.CancelResume(timer_); }
+
+  /// @brief 既に取り消されている場合は待たない
+  bool await_ready() {
+    cancelled_ = token_.IsCancelled();
+    return cancelled_;
+  }
+
+  template <TaskPromise Promise>
+  void await_suspend(std::coroutine_handle<Promise> handle) {
+    task_ = &handle.promise();
+    timer_ = ctx_.RequestResumeAt(ctx_.time.Now() + duration_, *task_);
+    token_.Register(*this);
+  }
+
+  /// @return 最後まで Sleep した場合 true (取り消された場合 false)
+  auto await_resume() -> bool {
+    this->Unlink();
+    return !cancelled_;
+  }
+};
+
 /// @brief Robobus Loop を用いて Sleep を行う
 /// @tparam Clock Clock の型
 /// @param ctx Loop のコンテキスト
@@ -39,6 +99,16 @@ struct SleepAwaiter {
 template <typename Clock>
   requires std::chrono::is_clock_v<Clock>
 auto Sleep(Loop<Clock> &ctx, typename Clock::duration duration) {
-  return SleepAwaiter(ctx, duration);
+  return SleepAwaiter<Clock>(ctx, duration);
+}
+
+/// @brief 取り消し可能な Sleep を行う
+/// @param token 途中で起こすためのトークン
+/// @return Awaiter (co_await の結果は，最後まで Sleep した場合 true)
+template <typename Clock>
+  requires std::chrono::is_clock_v<Clock>
+auto Sleep(Loop<Clock> &ctx, typename Clock::duration duration,
+           CancellationToken token) {
+  return CancellableSleepAwaiter<Clock>(ctx, duration, token);
 }
-}  // namespace robobus::runtime
\ No newline at end of file
+}  // namespace robobus::runtime
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <concepts>
+#include <coroutine>
+
+#include "../../internal/intrusive_list.hpp"
+#include "../../internal/intrusive_mpsc_queue.hpp"
+#include "../context/context_id.hpp"
+#include "priority.hpp"
+#include "task_profile.hpp"
+
+namespace robobus::runtime {
+/// @brief Loop の実行可能キューに連結するためのタグ
+struct ReadyQueueTag;
+
+/// @brief Loop のタスク一覧に連結するためのタグ
+struct TaskListTag;
+
+/// @brief Loop::ScheduleFromIsr() のキューに連結するためのタグ
+struct RemoteQueueTag;
+
+/// @brief 新しく作られたタスクが引き継ぐ優先度 (再開中のタスクの優先度)
+/// @details Loop がタスクを再開する間は PriorityScope でそのタスクの優先度になる．
+///  Mbed には TLS が無いので全スレッドで共有する (Loop を駆動するスレッドが
+///  1 つの前提)
+#if defined(__MBED__)
+inline Priority inherited_priority = Priority::kComms;
+#else
+inline thread_local Priority inherited_priority = Priority::kComms;
+#endif
+
+/// @brief 新しく作られたタスクが引き継ぐ所属 Context (再開中のタスクの所属)
+/// @details inherited_priority と同じく Loop が再開する間だけ設定する
+#if defined(__MBED__)
+inline context::ContextID inherited_owner = context::kNoContext;
+#else
+inline thread_local context::ContextID inherited_owner = context::kNoContext;
+#endif
+
+/// @brief スコープの間に作られたタスクの優先度を priority にする
+/// @details Coroutine は作られた時点で最初の中断点まで実行され，その中で
+///  作られた子のコルーチンも同じ優先度を引き継ぐ．
+///  最初の実行から優先度を効かせるには，コルーチンを作る前にこれを置く
+class PriorityScope {
+  Priority saved_;
+
+ public:
+  explicit PriorityScope(Priority priority) : saved_(inherited_priority) {
+    inherited_priority = priority;
+  }
+
+  ~PriorityScope() { inherited_priority = saved_; }
+
+  PriorityScope(PriorityScope const &) = delete;
+  PriorityScope &operator=(PriorityScope const &) = delete;
+};
+
+/// @brief スコープの間に作られたタスクの所属 Context を owner にする
+/// @details 計測結果は所属ごとに集計されるので，co_await した子の実行時間も
+///  親と同じ Context に数えられる
+class OwnerScope {
+  context::ContextID saved_;
+
+ public:
+  explicit OwnerScope(context::ContextID owner) : saved_(inherited_owner) {
+    inherited_owner = owner;
+  }
+
+  ~OwnerScope() { inherited_owner = saved_; }
+
+  OwnerScope(OwnerScope const &) = delete;
+  OwnerScope &operator=(OwnerScope const &) = delete;
+};
+
+/// @brief Loop が扱うタスクの管理情報
+/// @details Promise に埋め込まれ，Loop の各キューに侵入型リストとして連結される．
+///  コルーチンの終了 (フレームの破棄) と同時に自動でキューから外れる
+class TaskNode : public internal::IntrusiveListHook<ReadyQueueTag>,
+                 public internal::IntrusiveListHook<TaskListTag>,
+                 public internal::IntrusiveMpscHook<RemoteQueueTag> {
+  std::coroutine_handle<> handle_;
+  /// 所属する Context の番号 (計測結果の集計に用いる．作られた時点で再開中のタスクから引き継ぐ)
+  context::ContextID owner_ = inherited_owner;
+  /// 作られた時点で再開中のタスク (co_await した親) の優先度を引き継ぐ
+  Priority priority_ = inherited_priority;
+
+#if ROBOBUS_ENABLE_PROFILING
+  TaskProfile profile_;
+  /// 再開中のタスクが終了したことを Loop に伝えるためのポインタ
+  TaskNode **watcher_ = nullptr;
+  /// 計測結果の送り先 (`<owner>.profile`) の番号．初めて送る時に登録する
+  context::ContextID report_id_ = context::kNoContext;
+#endif
+
+ public:
+#if ROBOBUS_ENABLE_PROFILING
+  ~TaskNode() {
+    if (watcher_ != nullptr) {
+      *watcher_ = nullptr;
+    }
+  }
+
+  auto Profile() -> TaskProfile & { return profile_; }
+
+  auto Profile() const -> TaskProfile const & { return profile_; }
+
+  /// @brief このタスクが破棄されたら *watcher を nullptr にする
+  void Watch(TaskNode **watcher) { watcher_ = watcher; }
+
+  void SetReportID(context::ContextID id) { report_id_ = id; }
+
+  auto ReportID() const -> context::ContextID { return report_id_; }
+#endif
+
+  void SetHandle(std::coroutine_handle<> handle) { handle_ = handle; }
+
+  auto Handle() const -> std::coroutine_handle<> { return handle_; }
+
+  void SetOwner(context::ContextID owner) {
+    owner_ = owner;
+#if ROBOBUS_ENABLE_PROFILING
+    report_id_ = context::kNoContext;
+#endif
+  }
+
+  auto Owner() const -> context::ContextID { return owner_; }
+
+  void SetPriority(Priority priority) { priority_ = priority; }
+
+  auto GetPriority() const -> Priority { return priority_; }
+
+  auto IsReady() const -> bool {
+    return internal::IntrusiveListHook<ReadyQueueTag>::IsLinked();
+  }
+};
+
+/// @brief TaskNode を持つ Promise を表すコンセプト
+template <typename Promise>
+concept TaskPromise = std::derived_from<Promise, TaskNode>;
+}  // namespace robobus::runtime
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+#include "cycle_counter.hpp"
+
+/// @def ROBOBUS_ENABLE_PROFILING
+/// @brief 0 を定義するとタスクごとの計測を取り除く
+/// @details TaskNode の大きさが変わるため，全ての翻訳単位で同じ値にすること
+#ifndef ROBOBUS_ENABLE_PROFILING
+#define ROBOBUS_ENABLE_PROFILING 1
+#endif
+
+namespace robobus::runtime {
+/// @brief タスクごとの計測値
+struct TaskProfile {
+  /// 再開された回数
+  std::uint32_t resumes = 0;
+  /// タイマーによって再開された回数
+  std::uint32_t timer_wakes = 0;
+
+  /// 再開から中断までにかかったサイクル数の合計と最大値
+  std::uint64_t total_cycles = 0;
+  CycleCounter::Cycles max_cycles = 0;
+
+  /// 要求した時刻から実行可能になるまでの遅れの合計と最大値 [ns]
+  std::int64_t total_lateness_ns = 0;
+  std::int64_t max_lateness_ns = 0;
+
+  void RecordRun(CycleCounter::Cycles cycles) {
+    resumes++;
+    total_cycles += cycles;
+    if (max_cycles < cycles) {
+      max_cycles = cycles;
+    }
+  }
+
+  void RecordLateness(std::int64_t lateness_ns) {
+    timer_wakes++;
+    total_lateness_ns += lateness_ns;
+    if (max_lateness_ns < lateness_ns) {
+      max_lateness_ns = lateness_ns;
+    }
+  }
+
+  /// @brief 別のタスクの計測値を合算する (Context ごとの集計用)
+  void Merge(TaskProfile const &other) {
+    resumes += other.resumes;
+    total_cycles += other.total_cycles;
+    if (max_cycles < other.max_cycles) {
+      max_cycles = other.max_cycles;
+    }
+
+    timer_wakes += other.timer_wakes;
+    total_lateness_ns += other.total_lateness_ns;
+    if (max_lateness_ns < other.max_lateness_ns) {
+      max_lateness_ns = other.max_lateness_ns;
+    }
+  }
+};
+}  // namespace robobus::runtime
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+
+#include <chrono>
+#include <coroutine>
+
+#include "loop.hpp"
+
+namespace robobus::runtime {
+/// @brief 処理が周期を超えて tick の期限を過ぎていた時の振る舞い
+enum class TickPolicy {
+  /// 過ぎた tick を待たずに順に実行し，遅れを取り戻す
+  kCatchUp,
+  /// 過ぎた tick を捨て，次の期限まで待つ (周期の位相は保つ)
+  kSkip,
+};
+
+/// @brief Ticker の統計情報
+template <typename Clock>
+  requires std::chrono::is_clock_v<Clock>
+struct TickerStats {
+  /// 実行した tick の数
+  std::uint64_t ticks = 0;
+  /// 待ち始めた時点で期限を過ぎていた回数
+  std::uint64_t overruns = 0;
+  /// kSkip で捨てた tick の数
+  std::uint64_t skipped = 0;
+
+  /// 期限から再開までの遅れの最大値と合計
+  typename Clock::duration max_jitter = Clock::duration::zero();
+  typename Clock::duration total_jitter = Clock::duration::zero();
+
+  auto MeanJitter() const -> typename Clock::duration {
+    if (ticks == 0) {
+      return Clock::duration::zero();
+    }
+
+    return total_jitter / ticks;
+  }
+};
+
+/// @brief 絶対時刻の期限で周期実行するためのタイマー
+/// @details `co_await ticker` するたびに次の期限まで待つ．
+///  期限は前回の期限に周期を足したものなので，処理時間によって周期がずれない
+template <typename Clock>
+  requires std::chrono::is_clock_v<Clock>
+class Ticker {
+  Loop<Clock> &loop_;
+  typename Clock::duration period_;
+  TickPolicy policy_;
+
+  typename Clock::time_point deadline_;
+  TickerStats<Clock> stats_;
+
+  /// @return 待たずに tick を実行できる場合 true
+  auto Arm() -> bool {
+    auto now = loop_.time.Now();
+    if (now <= deadline_) {
+      return now == deadline_;
+    }
+
+    stats_.overruns++;
+    if (policy_ == TickPolicy::kCatchUp) {
+      return true;
+    }
+
+    auto missed = static_cast<std::uint64_t>((now - deadline_) / period_) + 1;
+    deadline_ += period_ * missed;
+    stats_.skipped += missed;
+
+    return false;
+  }
+
+  void Tick() {
+    auto jitter = loop_.time.Now() - deadline_;
+
+    stats_.ticks++;
+    stats_.total_jitter += jitter;
+    if (stats_.max_jitter < jitter) {
+      stats_.max_jitter = jitter;
+    }
+
+    deadline_ += period_;
+  }
+
+  class Awaiter {
+    Ticker &ticker_;
+    TimerId timer_{};
+
+   public:
+    explicit Awaiter(Ticker &ticker) : ticker_(ticker) {}
+
+    Awaiter(Awaiter const &) = delete;
+    Awaiter &operator=(Awaiter const &) = delete;
+
+    /// @brief 待っている間にコルーチンが破棄された場合はタイマーも取り消す
+    ~Awaiter() { ticker_.loop_.CancelResume(timer_); }
+
+    bool await_ready() { return ticker_.Arm(); }
+
+    template <TaskPromise Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) {
+      timer_ =
+          ticker_.loop_.RequestResumeAt(ticker_.deadline_, handle.promise());
+    }
+
+    void await_resume() { ticker_.Tick(); }
+  };
+
+ public:
+  /// @brief 最初の tick は現在時刻から 1 周期後
+  Ticker(Loop<Clock> &loop, typename Clock::duration period,
+         TickPolicy policy = TickPolicy::kCatchUp)
+      : loop_(loop),
+        period_(period),
+        policy_(policy),
+        deadline_(loop.time.Now() + period) {}
+
+  auto operator co_await() { return Awaiter{*this}; }
+
+  auto Period() const -> typename Clock::duration { return period_; }
+
+  auto Stats() const -> TickerStats<Clock> const & { return stats_; }
+
+  void ResetStats() { stats_ = {}; }
+};
+
+/// @brief 周期実行のためのタイマーを作る
+/// @param loop 再開に用いる Loop
+/// @param period 周期
+/// @param policy 期限を過ぎていた時の振る舞い
+template <typename Clock>
+  requires std::chrono::is_clock_v<Clock>
+auto Every(Loop<Clock> &loop, typename Clock::duration period,
+           TickPolicy policy = TickPolicy::kCatchUp) {
+  return Ticker<Clock>(loop, period, policy);
+}
+}  // namespace robobus::runtime
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <utility>
+
+#include "../coroutine/task.hpp"
+#include "../coroutine/when.hpp"
+#include "loop.hpp"
+#include "sleep.hpp"
+
+namespace robobus::runtime {
+namespace detail {
+template <typename Clock>
+  requires std::chrono::is_clock_v<Clock>
+auto SleepTask(Loop<Clock> &loop, typename Clock::duration duration)
+    -> coroutine::Task<void> {
+  co_await Sleep(loop, duration);
+}
+}  // namespace detail
+
+/// @brief タスクを期限付きで待つ
+/// @details 期限までに終わらなかったタスクはフレームごと破棄される
+/// @return タスクの結果 (期限切れの場合 std::nullopt．void は std::monostate)
+template <typename Clock, typename T>
+  requires std::chrono::is_clock_v<Clock>
+auto WithTimeout(Loop<Clock> &loop, coroutine::Task<T> task,
+                 typename Clock::duration timeout)
+    -> coroutine::Task<std::optional<coroutine::ValueOf<T>>> {
+  auto result = co_await coroutine::WhenAny(
+      std::move(task), detail::SleepTask(loop, timeout));
+
+  if (result.index() != 0) {
+    co_return std::nullopt;
+  }
+
+  co_return std::move(std::get<0>(result));
+}
+}  // namespace robobus::runtime
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <vector>
+
+namespace robobus::runtime {
+/// @brief TimerQueue に登録したエントリの識別子
+struct TimerId {
+  static constexpr std::uint32_t kInvalidSlot = UINT32_MAX;
+
+  std::uint32_t slot = kInvalidSlot;
+  std::uint32_t generation = 0;
+
+  auto IsValid() const -> bool { return slot != kInvalidSlot; }
+};
+
+/// @brief 期限付きのエントリを管理するタイマーキュー (二分ヒープ)
+/// @details 追加・取り出しは O(log n)，取り消しは O(1)．
+///  同じ期限のエントリは追加順に取り出される．
+///  内部配列は縮小しないため，一度最大数に達した後はメモリ確保が発生しない
+/// @tparam TimePoint 期限の型
+/// @tparam Payload 期限到達時に取り出すデータの型
+template <typename TimePoint, typename Payload>
+class TimerQueue {
+  struct Entry {
+    TimePoint deadline;
+    std::uint32_t seq;
+    std::uint32_t slot;
+    std::uint32_t generation;
+  };
+
+  /// @brief エントリの実体 (取り消された場合は世代が進む)
+  struct Slot {
+    Payload payload;
+    std::uint32_t generation;
+    std::uint32_t next_free;
+  };
+
+  std::vector<Entry> heap_;
+  std::vector<Slot> slots_;
+  std::uint32_t free_slot_ = TimerId::kInvalidSlot;
+  std::uint32_t next_seq_ = 0;
+
+  /// ヒープ内に残っている取り消し済みエントリの数
+  std::size_t cancelled_ = 0;
+
+  /// @brief 追加順の比較 (オーバーフローを考慮)
+  static bool SeqBefore(std::uint32_t a, std::uint32_t b) {
+    return static_cast<std::int32_t>(a - b) < 0;
+  }
+
+  /// @brief std::*_heap は最大ヒープなので，比較を反転して最小ヒープにする
+  static bool Later(Entry const &a, Entry const &b) {
+    if (a.deadline != b.deadline) {
+      return b.deadline < a.deadline;
+    }
+
+    return SeqBefore(b.seq, a.seq);
+  }
+
+  auto IsLive(Entry const &entry) const -> bool {
+    return slots_[entry.slot].generation == entry.generation;
+  }
+
+  auto AllocateSlot(Payload payload) -> std::uint32_t {
+    if (free_slot_ != TimerId::kInvalidSlot) {
+      auto index = free_slot_;
+      free_slot_ = slots_[index].next_free;
+      slots_[index].payload = payload;
+      return index;
+    }
+
+    slots_.push_back(Slot{payload, 0, TimerId::kInvalidSlot});
+    return static_cast<std::uint32_t>(slots_.size() - 1);
+  }
+
+  void ReleaseSlot(std::uint32_t index) {
+    slots_[index].generation++;
+    slots_[index].next_free = free_slot_;
+    free_slot_ = index;
+  }
+
+  /// @brief 先頭の取り消し済みエントリを捨てる (先頭が常に有効になるように)
+  void DropCancelledTop() {
+    while (!heap_.empty() && !IsLive(heap_.front())) {
+      std::pop_heap(heap_.begin(), heap_.end(), Later);
+      heap_.pop_back();
+      cancelled_--;
+    }
+  }
+
+  /// @brief 取り消し済みエントリが多くなったらヒープを作り直す (償却 O(1))
+  void CompactIfNeeded() {
+    if (cancelled_ < 16 || cancelled_ * 2 < heap_.size()) {
+      return;
+    }
+
+    std::erase_if(heap_, [this](Entry const &entry) { return !IsLive(entry); });
+    std::make_heap(heap_.begin(), heap_.end(), Later);
+    cancelled_ = 0;
+  }
+
+ public:
+  /// @brief 内部配列を事前に確保する
+  void Reserve(std::size_t capacity) {
+    heap_.reserve(capacity);
+    slots_.reserve(capacity);
+  }
+
+  auto Empty() const -> bool { return heap_.empty(); }
+
+  /// @brief 有効なエントリの数
+  auto Size() const -> std::size_t { return heap_.size() - cancelled_; }
+
+  /// @brief 最も早い期限を取得する (Empty() でないこと)
+  auto NextDeadline() const -> TimePoint const & {
+    return heap_.front().deadline;
+  }
+
+  /// @brief エントリを追加する
+  auto Push(TimePoint deadline, Payload payload) -> TimerId {
+    auto slot = AllocateSlot(payload);
+    auto generation = slots_[slot].generation;
+
+    heap_.push_back(Entry{deadline, next_seq_++, slot, generation});
+    std::push_heap(heap_.begin(), heap_.end(), Later);
+
+    return TimerId{slot, generation};
+  }
+
+  /// @brief エントリを取り消す (O(1))
+  /// @return 取り消せた場合 true (既に取り出された/取り消された場合 false)
+  auto Cancel(TimerId id) -> bool {
+    if (!id.IsValid() || slots_.size() <= id.slot ||
+        slots_[id.slot].generation != id.generation) {
+      return false;
+    }
+
+    ReleaseSlot(id.slot);
+    cancelled_++;
+
+    DropCancelledTop();
+    CompactIfNeeded();
+
+    return true;
+  }
+
+  /// @brief 期限が now 以前のエントリをすべて取り出し，f(payload, deadline) を呼ぶ
+  /// @details f の中で追加されたエントリはこの呼び出しでは取り出さない
+  ///  (0 秒 Sleep を繰り返すコルーチンで無限ループにならないように)
+  template <typename F>
+  void PopDue(TimePoint now, F &&f) {
+    const auto seq_limit = next_seq_;
+
+    while (!heap_.empty()) {
+      auto const &top = heap_.front();
+      if (now < top.deadline || !SeqBefore(top.seq, seq_limit)) {
+        break;
+      }
+
+      std::pop_heap(heap_.begin(), heap_.end(), Later);
+      auto entry = heap_.back();
+      heap_.pop_back();
+
+      auto payload = slots_[entry.slot].payload;
+      ReleaseSlot(entry.slot);
+      DropCancelledTop();
+
+      f(payload, entry.deadline);
+    }
+  }
+};
+}  // namespace robobus::runtime
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <concepts>
+
+namespace robobus::runtime {
+/// @brief 手動で進める仮想時計
+/// @details Loop<VirtualClock> は実行可能なタスクが無い時，
+///  眠る代わりに次の期限まで時計を進める．
+///  整数の時刻を用いるため，同じプログラムは毎回同じ順序で再開される
+class VirtualClock {
+ public:
+  using duration = std::chrono::nanoseconds;
+  using rep = duration::rep;
+  using period = duration::period;
+  using time_point = std::chrono::time_point<VirtualClock, duration>;
+
+  static constexpr bool is_steady = true;
+
+ private:
+  static inline time_point now_{};
+
+ public:
+  static auto now() -> time_point { return now_; }
+
+  /// @brief 指定時刻まで時計を進める (過去の時刻は無視する)
+  static void AdvanceTo(time_point time) {
+    if (now_ < time) {
+      now_ = time;
+    }
+  }
+
+  static void AdvanceBy(duration delta) { AdvanceTo(now_ + delta); }
+
+  /// @brief 時計を 0 に戻す (Loop の生成前に呼ぶこと)
+  static void Reset() { now_ = time_point{}; }
+};
+
+/// @brief Loop が直接進めることのできる時計を表すコンセプト
+template <typename Clock>
+concept AdvanceableClock = requires(typename Clock::time_point time) {
+  { Clock::AdvanceTo(time) };
+};
+}  // namespace robobus::runtime
@@ -0,0 +1,503 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <array>
+#include <memory>
+#include <optional>
+
+#include "../../internal/rtt_estimator.hpp"
+#include "../../internal/signal.hpp"
+
+namespace robobus::stream {
+/// @brief ControlStream で 1 フレームに載せるデータ
+struct StreamPayload {
+  /// データフレームの先頭 1 バイトは通し番号に使う
+  static constexpr std::size_t kMaxSize = 7;
+
+  std::array<std::uint8_t, kMaxSize> data;
+  std::uint8_t size;
+};
+
+/// @brief ControlStream が送出する CAN フレーム (最大 8 バイト)
+struct StreamFrame {
+  std::array<std::uint8_t, 8> data;
+  std::uint8_t size;
+};
+
+struct ControlStreamConfig {
+  /// 確認を待たずに送れるフレームの数 (1 で stop-and-wait)
+  std::uint8_t window = 8;
+  /// 順序通りに受け取ったフレームがこの数に達したら確認を返す
+  /// (達しなくても次の Tick() で返す)
+  std::uint8_t ack_every = 4;
+
+  internal::RetransmitConfig retransmit = {};
+
+  /// @brief 同期 (SYN) に付ける値の初期値
+  /// @details 相手が古い SYN と新しい SYN を見分けるのに使うので，
+  ///  起動するたびに異なる値 (乱数など) を与えること
+  std::uint16_t sync_nonce = 0;
+};
+
+struct ControlStreamStats {
+  /// 新しく送ったデータフレームの数
+  std::uint32_t sent = 0;
+  /// タイマーによる再送の数 (フレーム単位)
+  std::uint32_t retransmits = 0;
+  /// 確認を受け取ったデータフレームの数
+  std::uint32_t acked = 0;
+  /// 順序通りに上位へ渡したフレームの数
+  std::uint32_t delivered = 0;
+  /// 既に受け取っていたフレームを再び受け取った数
+  std::uint32_t duplicates = 0;
+  /// 順序を飛ばして受け取り，保留したフレームの数
+  std::uint32_t out_of_order = 0;
+  /// 送った確認フレームの数
+  std::uint32_t acks_sent = 0;
+  /// 送信側が同期をやり直した回数 (最初の同期を含む)
+  std::uint32_t syncs = 0;
+  /// 相手の送信側の新しい同期を受け入れた回数
+  std::uint32_t peer_syncs = 0;
+};
+
+/// @brief 複数のフレームを確認待ちのまま送れる制御ストリーム (選択的再送)
+/// @details フレームの書式:
+///  - データ: `[seq] [payload 0..7]` (seq はフレームごとの 8bit の通し番号)
+///  - 確認:   `[next] [sack 0..3]` (next まで順に受信済み．sack の bit i は
+///    next + 1 + i を受信済み)
+///  - 同期:   `[kSync] [base] [nonce 0..1]` / `[kSyncAck] [base] [nonce 0..1]`
+///  - 同期要求: `[kSyncRequest]`
+///
+///  確認と同期は長さで見分ける．送信側は最初のデータを送る前に SYN で
+///  通し番号の起点 (base) を伝え，SYN-ACK を受け取ってからデータを送る．
+///  受信側は nonce の異なる SYN を受け取ると，保留していたフレームを捨てて
+///  base から受け取り直す (同じ nonce の SYN は再送とみなして SYN-ACK だけ返す)．
+///  一度も同期していない受信側 (再起動した相手など) はデータを受け取ると
+///  同期要求を返し，送信側は確認待ちのフレームを base から送り直す．
+///  これにより，どちらが再起動しても通信が再開する
+///
+///  送信側は window 個まで確認を待たずに送り，フレームごとのタイマーが切れた
+///  ものだけを再送する．再送間隔は RTT から求め (RttEstimator)，
+///  タイマーが切れるたびに (全てのフレームで共通の) 再送間隔を倍にして，
+///  次に RTT を計測できた時に戻す．受信側は順序を飛ばしたフレームを保留し，
+///  欠けたフレームが揃った時点で順に rx_data へ渡す．
+///  時間は MultiUpdatable と同じく Tick() で進める
+/// @tparam MaxWindow 送受信のバッファの大きさ (2 の冪，32 以下)
+template <std::size_t MaxWindow = 32>
+class ControlStream {
+  static_assert(MaxWindow != 0 && (MaxWindow & (MaxWindow - 1)) == 0,
+                "MaxWindow must be a power of two");
+  static_assert(MaxWindow <= 32, "MaxWindow must fit the 32-bit SACK field");
+
+  struct TxSlot {
+    StreamPayload payload;
+    /// 最初に送ってからの経過時間 [s]
+    float age_s;
+    /// 次の再送までの時間 [s]
+    float timer_s;
+    /// 1 度でも再送したか (再送したものは RTT の計測に使わない)
+    bool retransmitted;
+    bool acked;
+  };
+
+  enum class TxState : std::uint8_t {
+    /// まだ何も送っていない
+    kUnsynced,
+    /// SYN-ACK を待っている (データは送らない)
+    kSyncing,
+    kSynced,
+  };
+
+  /// 同期フレームの種類 (確認フレームとは長さで見分ける)
+  static constexpr std::uint8_t kSync = 0x01;
+  static constexpr std::uint8_t kSyncAck = 0x02;
+  static constexpr std::uint8_t kSyncRequest = 0x03;
+  static constexpr std::size_t kSyncSize = 4;
+  static constexpr std::size_t kAckSize = 5;
+
+  struct RxSlot {
+    StreamPayload payload;
+    bool filled;
+  };
+
+  ControlStreamConfig config_;
+  internal::RttEstimator rtt_;
+  ControlStreamStats stats_;
+
+  std::array<TxSlot, MaxWindow> tx_{};
+  /// 確認を待っている最も古いフレームの番号
+  std::uint8_t tx_base_ = 0;
+  /// 次に送るフレームの番号
+  std::uint8_t tx_next_ = 0;
+  TxState tx_state_ = TxState::kUnsynced;
+  /// 送った (もしくは次に送る) SYN の nonce
+  std::uint16_t tx_nonce_;
+  float sync_timer_s_ = 0;
+
+  std::array<RxSlot, MaxWindow> rx_{};
+  /// 次に受け取るべきフレームの番号
+  std::uint8_t rx_next_ = 0;
+  /// 確認を返していない受信フレームの数
+  std::uint8_t unacked_rx_ = 0;
+  /// 受け入れた SYN の nonce (まだ同期していなければ std::nullopt)
+  std::optional<std::uint16_t> rx_nonce_ = std::nullopt;
+
+  /// 直前の Tick() の間隔 [s]
+  /// @details 経過時間は Tick() ごとにしか進まないため，再送タイマーには
+  ///  この分の余裕を持たせる (早すぎる再送を防ぐ)
+  float tick_s_ = 0;
+
+  internal::SignalTx<StreamFrame> tx_data_tx_{
+      std::make_shared<internal::Signal<StreamFrame>>()};
+  internal::SignalTx<StreamFrame> tx_ctrl_tx_{
+      std::make_shared<internal::Signal<StreamFrame>>()};
+  internal::SignalTx<StreamPayload> rx_data_tx_{
+      std::make_shared<internal::Signal<StreamPayload>>()};
+  internal::SignalTx<std::uint8_t> tx_ready_tx_{
+      std::make_shared<internal::Signal<std::uint8_t>>()};
+
+  static auto Slot(std::uint8_t seq) -> std::size_t {
+    return seq & (MaxWindow - 1);
+  }
+
+  auto Window() const -> std::uint8_t {
+    return config_.window < MaxWindow ? config_.window : MaxWindow;
+  }
+
+  void SendData(std::uint8_t seq) {
+    auto const &payload = tx_[Slot(seq)].payload;
+
+    StreamFrame frame;
+    frame.data[0] = seq;
+    std::memcpy(&frame.data[1], payload.data.data(), payload.size);
+    frame.size = payload.size + 1;
+
+    tx_data_tx_.Fire(frame);
+  }
+
+  void SendAck() {
+    std::uint32_t sack = 0;
+    for (std::size_t i = 0; i + 1 < MaxWindow; i++) {
+      if (rx_[Slot(rx_next_ + 1 + i)].filled) {
+        sack |= 1u << i;
+      }
+    }
+
+    StreamFrame frame;
+    frame.data[0] = rx_next_;
+    frame.data[1] = sack & 0xFF;
+    frame.data[2] = (sack >> 8) & 0xFF;
+    frame.data[3] = (sack >> 16) & 0xFF;
+    frame.data[4] = (sack >> 24) & 0xFF;
+    frame.size = 5;
+
+    unacked_rx_ = 0;
+    stats_.acks_sent++;
+    tx_ctrl_tx_.Fire(frame);
+  }
+
+  void SendSyncFrame(std::uint8_t kind, std::uint8_t base,
+                     std::uint16_t nonce) {
+    StreamFrame frame;
+    frame.data[0] = kind;
+    frame.data[1] = base;
+    frame.data[2] = nonce & 0xFF;
+    frame.data[3] = nonce >> 8;
+    frame.size = kSyncSize;
+
+    tx_ctrl_tx_.Fire(frame);
+  }
+
+  /// @brief 新しい nonce で同期を始める (SYN-ACK まではデータを送らない)
+  void StartSync() {
+    tx_state_ = TxState::kSyncing;
+    tx_nonce_++;
+    sync_timer_s_ = rtt_.Timeout() + tick_s_;
+
+    stats_.syncs++;
+    SendSyncFrame(kSync, tx_base_, tx_nonce_);
+  }
+
+  /// @brief SYN-ACK を受け取った．確認待ちのフレームを全て送り直す
+  /// @details 相手が保留していたフレームは同期で捨てられているので，
+  ///  SACK で確認済みのものも送り直す
+  void CompleteSync() {
+    tx_state_ = TxState::kSynced;
+
+    for (std::uint8_t seq = tx_base_; seq != tx_next_; seq++) {
+      auto &slot = tx_[Slot(seq)];
+      slot.acked = false;
+      slot.age_s = 0;
+      slot.retransmitted = false;
+      slot.timer_s = rtt_.Timeout() + tick_s_;
+      SendData(seq);
+    }
+  }
+
+  /// @brief 相手の送信側からの SYN を受け入れる
+  void AcceptSync(std::uint8_t base, std::uint16_t nonce) {
+    if (rx_nonce_ != nonce) {
+      rx_nonce_ = nonce;
+      rx_next_ = base;
+      unacked_rx_ = 0;
+      for (auto &slot : rx_) {
+        slot.filled = false;
+      }
+      stats_.peer_syncs++;
+    }
+
+    // 同じ nonce の SYN (再送) にも SYN-ACK を返す
+    SendSyncFrame(kSyncAck, base, nonce);
+  }
+
+  void LoadSyncFrame(std::uint8_t const *data, std::size_t size) {
+    if (size == 1 && data[0] == kSyncRequest) {
+      if (tx_state_ == TxState::kSynced) {
+        StartSync();
+      }
+      return;
+    }
+
+    if (size != kSyncSize) {
+      return;
+    }
+
+    auto base = data[1];
+    auto nonce = static_cast<std::uint16_t>(data[2] | data[3] << 8);
+    if (data[0] == kSync) {
+      AcceptSync(base, nonce);
+    } else if (data[0] == kSyncAck && tx_state_ == TxState::kSyncing &&
+               nonce == tx_nonce_ && base == tx_base_) {
+      CompleteSync();
+    }
+  }
+
+  /// @brief seq の確認を受け取った
+  void Ack(std::uint8_t seq) {
+    auto &slot = tx_[Slot(seq)];
+    if (slot.acked) {
+      return;
+    }
+
+    slot.acked = true;
+    stats_.acked++;
+
+    if (!slot.retransmitted) {
+      rtt_.Sample(slot.age_s);
+    }
+  }
+
+ public:
+  /// @brief 送るデータフレーム (CAN のデータ用の ID で送ること)
+  internal::SignalRx<StreamFrame> tx_data{tx_data_tx_};
+  /// @brief 送る確認フレーム (CAN の制御用の ID で送ること)
+  internal::SignalRx<StreamFrame> tx_ctrl{tx_ctrl_tx_};
+  /// @brief 順序通りに並べ直した受信データ
+  internal::SignalRx<StreamPayload> rx_data{rx_data_tx_};
+  /// @brief 確認によって送信枠が空いた (引数は空いている枠の数)
+  internal::SignalRx<std::uint8_t> tx_ready{tx_ready_tx_};
+
+  explicit ControlStream(ControlStreamConfig config = {})
+      : config_(config),
+        rtt_(config.retransmit),
+        tx_nonce_(config.sync_nonce) {}
+
+  ControlStream(ControlStream const &) = delete;
+  ControlStream &operator=(ControlStream const &) = delete;
+
+  /// @brief 確認待ちのフレームの数
+  auto InFlight() const -> std::uint8_t {
+    return static_cast<std::uint8_t>(tx_next_ - tx_base_);
+  }
+
+  /// @brief 送信枠に空きがあるか
+  auto CanSend() const -> bool { return InFlight() < Window(); }
+
+  /// @brief データを 1 フレームとして送る
+  /// @param size StreamPayload::kMaxSize まで
+  /// @return 送信枠が埋まっている (もしくは size が大きすぎる) 場合 false
+  auto Send(std::uint8_t const *data, std::size_t size) -> bool {
+    if (!CanSend() || StreamPayload::kMaxSize < size) {
+      return false;
+    }
+
+    auto seq = tx_next_++;
+    auto &slot = tx_[Slot(seq)];
+    std::memcpy(slot.payload.data.data(), data, size);
+    slot.payload.size = static_cast<std::uint8_t>(size);
+    slot.age_s = 0;
+    slot.retransmitted = false;
+    slot.timer_s = rtt_.Timeout() + tick_s_;
+    slot.acked = false;
+
+    stats_.sent++;
+    if (tx_state_ == TxState::kSynced) {
+      SendData(seq);
+    } else if (tx_state_ == TxState::kUnsynced) {
+      // 確認待ちのフレームは SYN-ACK を受け取った時に送る
+      StartSync();
+    }
+
+    return true;
+  }
+
+  /// @brief データ用の ID で受け取ったフレームを処理する
+  void FeedRxData(std::uint8_t const *data, std::size_t size) {
+    if (size < 1 || StreamPayload::kMaxSize + 1 < size) {
+      return;
+    }
+
+    if (!rx_nonce_.has_value()) {
+      // 相手の SYN を受け取っていない (こちらが再起動した) ので同期し直してもらう
+      StreamFrame frame;
+      frame.data[0] = kSyncRequest;
+      frame.size = 1;
+      tx_ctrl_tx_.Fire(frame);
+      return;
+    }
+
+    auto seq = data[0];
+    auto offset = static_cast<std::uint8_t>(seq - rx_next_);
+    if (MaxWindow <= offset) {
+      // 既に受け取ったフレーム (確認が届いていない) なのですぐに確認を返す
+      stats_.duplicates++;
+      SendAck();
+      return;
+    }
+
+    auto &slot = rx_[Slot(seq)];
+    if (slot.filled) {
+      stats_.duplicates++;
+      return;
+    }
+
+    std::memcpy(slot.payload.data.data(), data + 1, size - 1);
+    slot.payload.size = static_cast<std::uint8_t>(size - 1);
+    slot.filled = true;
+    unacked_rx_++;
+
+    if (offset != 0) {
+      // 欠けたフレームがあることを早く伝える
+      stats_.out_of_order++;
+      SendAck();
+      return;
+    }
+
+    while (rx_[Slot(rx_next_)].filled) {
+      auto &next = rx_[Slot(rx_next_)];
+      next.filled = false;
+      rx_next_++;
+
+      stats_.delivered++;
+      rx_data_tx_.Fire(next.payload);
+    }
+
+    if (config_.ack_every <= unacked_rx_) {
+      SendAck();
+    }
+  }
+
+  /// @brief 制御用の ID で受け取った確認・同期フレームを処理する
+  void LoadRxControlData(std::uint8_t const *data, std::size_t size) {
+    if (size != kAckSize) {
+      LoadSyncFrame(data, size);
+      return;
+    }
+    if (tx_state_ != TxState::kSynced) {
+      // 同期前 (もしくは同期し直している間) の確認は古い相手のもの
+      return;
+    }
+
+    auto next = data[0];
+    auto sack = static_cast<std::uint32_t>(data[1]) |
+                (static_cast<std::uint32_t>(data[2]) << 8) |
+                (static_cast<std::uint32_t>(data[3]) << 16) |
+                (static_cast<std::uint32_t>(data[4]) << 24);
+
+    auto acked = static_cast<std::uint8_t>(next - tx_base_);
+    if (InFlight() < acked) {
+      // 古い確認
+      return;
+    }
+
+    for (std::uint8_t seq = tx_base_; seq != next; seq++) {
+      Ack(seq);
+    }
+
+    for (std::size_t i = 0; i + 1 < MaxWindow; i++) {
+      auto seq = static_cast<std::uint8_t>(next + 1 + i);
+      if ((sack >> i & 1) != 0 &&
+          static_cast<std::uint8_t>(seq - tx_base_) < InFlight()) {
+        Ack(seq);
+      }
+    }
+
+    auto was_full = !CanSend();
+    while (tx_base_ != tx_next_ && tx_[Slot(tx_base_)].acked) {
+      tx_base_++;
+    }
+
+    if (acked != 0 || was_full != !CanSend()) {
+      tx_ready_tx_.Fire(static_cast<std::uint8_t>(Window() - InFlight()));
+    }
+  }
+
+  /// @param delta_time_s 前回の Tick() 呼び出しからの経過時間 [s]
+  void Tick(float delta_time_s) {
+    tick_s_ = delta_time_s;
+
+    if (tx_state_ == TxState::kSyncing) {
+      sync_timer_s_ -= delta_time_s;
+      if (sync_timer_s_ <= 0) {
+        rtt_.Backoff();
+        sync_timer_s_ = rtt_.Timeout() + tick_s_;
+        SendSyncFrame(kSync, tx_base_, tx_nonce_);
+      }
+    }
+
+    auto expired = false;
+    for (std::uint8_t seq = tx_base_;
+         tx_state_ == TxState::kSynced && seq != tx_next_; seq++) {
+      auto &slot = tx_[Slot(seq)];
+      if (slot.acked) {
+        continue;
+      }
+
+      slot.age_s += delta_time_s;
+      slot.timer_s -= delta_time_s;
+      if (0 < slot.timer_s) {
+        continue;
+      }
+
+      if (!expired) {
+        // 同じ Tick() で切れたタイマーについては 1 度だけ倍にする
+        rtt_.Backoff();
+        expired = true;
+      }
+      slot.retransmitted = true;
+      slot.timer_s = rtt_.Timeout() + tick_s_;
+
+      stats_.retransmits++;
+      SendData(seq);
+    }
+
+    if (unacked_rx_ != 0) {
+      SendAck();
+    }
+  }
+
+  /// @brief 現在の再送間隔 (バックオフを含む) [s]
+  auto RetransmitTimeout() const -> float { return rtt_.Timeout(); }
+
+  auto SmoothedRtt() const -> std::optional<float> {
+    return rtt_.SmoothedRtt();
+  }
+
+  auto Stats() const -> ControlStreamStats const & { return stats_; }
+
+  void ResetStats() { stats_ = {}; }
+};
+}  // namespace robobus::stream
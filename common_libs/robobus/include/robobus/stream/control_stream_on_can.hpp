@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+
+#include <memory>
+#include <span>
+
+#include <robotics/platform/panic.hpp>
+
+#include "control_stream.hpp"
+#include "../router/message_router.hpp"
+#include "../../types/message_id.hpp"
+
+namespace robobus::stream {
+/// @brief CAN 上での制御ストリーム
+/// @details データと確認をそれぞれ別の MessageID で送受信する．
+///  受信は router に rx_ctrl_msg_id と rx_data_msg_id を Bind() して受け取る
+/// @tparam MaxWindow ControlStream の MaxWindow
+template <std::size_t MaxWindow = 32>
+class ControlStreamOnCAN {
+ public:
+  struct Config {
+    std::shared_ptr<router::MessageRouter> router;
+    types::MessageID tx_ctrl_msg_id;
+    types::MessageID rx_ctrl_msg_id;
+    types::MessageID tx_data_msg_id;
+    types::MessageID rx_data_msg_id;
+
+    ControlStreamConfig stream = {};
+  };
+
+ private:
+  std::shared_ptr<router::MessageRouter> router_;
+  ControlStream<MaxWindow> st_;
+
+  types::MessageID tx_ctrl_msg_id_;
+  types::MessageID rx_ctrl_msg_id_;
+  types::MessageID tx_data_msg_id_;
+  types::MessageID rx_data_msg_id_;
+
+  void SendFrame(types::MessageID id, StreamFrame const &frame) {
+    router_->Send(types::CanFrame::Create(
+        id.GetMsgID(), std::span(frame.data.data(), frame.size),
+        types::CanFrameFlags::kExtended));
+  }
+
+ public:
+  internal::SignalRx<StreamPayload> rx_data{st_.rx_data};
+  internal::SignalRx<std::uint8_t> tx_ready{st_.tx_ready};
+
+  explicit ControlStreamOnCAN(Config const &config)
+      : router_(config.router),
+        st_(config.stream),
+        tx_ctrl_msg_id_(config.tx_ctrl_msg_id),
+        rx_ctrl_msg_id_(config.rx_ctrl_msg_id),
+        tx_data_msg_id_(config.tx_data_msg_id),
+        rx_data_msg_id_(config.rx_data_msg_id) {
+    st_.tx_ctrl.Connect([this](StreamFrame const &frame) {
+      SendFrame(tx_ctrl_msg_id_, frame);
+    });
+    st_.tx_data.Connect([this](StreamFrame const &frame) {
+      SendFrame(tx_data_msg_id_, frame);
+    });
+
+    auto bound =
+        router_->Bind(rx_ctrl_msg_id_,
+                      [this](router::DecodedID const &,
+                             types::CanFrame const &frame) {
+                        st_.LoadRxControlData(frame.data.data(), frame.size);
+                      }) &&
+        router_->Bind(rx_data_msg_id_,
+                      [this](router::DecodedID const &,
+                             types::CanFrame const &frame) {
+                        st_.FeedRxData(frame.data.data(), frame.size);
+                      });
+    if (!bound) {
+      robotics::system::panic(
+          "ControlStreamOnCAN: rx MessageID is already bound to the router");
+    }
+  }
+
+  ~ControlStreamOnCAN() {
+    router_->Unbind(rx_ctrl_msg_id_);
+    router_->Unbind(rx_data_msg_id_);
+  }
+
+  ControlStreamOnCAN(ControlStreamOnCAN const &) = delete;
+  ControlStreamOnCAN &operator=(ControlStreamOnCAN const &) = delete;
+
+  /// @copydoc ControlStream::Send
+  auto Send(std::uint8_t const *data, std::size_t size) -> bool {
+    return st_.Send(data, size);
+  }
+
+  auto CanSend() const -> bool { return st_.CanSend(); }
+
+  auto Stream() -> ControlStream<MaxWindow> & { return st_; }
+
+  void Tick(float delta_time_s) { st_.Tick(delta_time_s); }
+};
+}  // namespace robobus::stream
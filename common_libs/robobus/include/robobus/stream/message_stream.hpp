@@ -0,0 +1,340 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <span>
+
+#include "control_stream.hpp"
+#include "../../internal/crc16.hpp"
+
+namespace robobus::stream {
+/// @brief メッセージを ControlStream のフレームへ分割する際の書式
+/// @details ControlStream が順序と到達を保証するので，フレームの位置だけで
+///  どのフレームが何かが決まる．メッセージは kChunkSize バイトごとのチャンクに分け，
+///  各チャンクの前にヘッダを置く (リトルエンディアン):
+///  - 最初のチャンク: `[kMessageStart] [length u16] [FullCRC u16] [ChunkCRC u16]`
+///  - 以降のチャンク: `[kChunkStart] [index u16] [ChunkCRC u16]`
+///
+///  ヘッダに続けて，チャンクのデータを 7 バイトずつ (最後は残り全部) 送る．
+///  CRC はいずれも CRC-16/CCITT-FALSE．ChunkCRC でチャンクごとに早く誤りを
+///  検出し，FullCRC で組み立て後のメッセージ全体を確かめる
+namespace segment {
+constexpr std::uint8_t kMessageStart = 0x01;
+constexpr std::uint8_t kChunkStart = 0x02;
+
+/// 1 チャンクのデータフレームの数
+constexpr std::size_t kChunkFrames = 8;
+constexpr std::size_t kChunkSize = kChunkFrames * StreamPayload::kMaxSize;
+
+inline void PutU16(std::uint8_t *dst, std::uint16_t value) {
+  dst[0] = value & 0xFF;
+  dst[1] = value >> 8;
+}
+
+inline auto GetU16(std::uint8_t const *src) -> std::uint16_t {
+  return static_cast<std::uint16_t>(src[0] | src[1] << 8);
+}
+}  // namespace segment
+
+/// @brief メッセージをフレームに分割して送るもの
+/// @tparam MaxMessageSize 1 メッセージの最大長 (送信用のバッファの大きさ)
+template <std::size_t MaxMessageSize>
+class Segmenter {
+  static_assert(MaxMessageSize <= 0xFFFF);
+
+  std::array<std::uint8_t, MaxMessageSize> buffer_{};
+  std::size_t size_ = 0;
+  std::size_t offset_ = 0;
+  std::uint16_t full_crc_ = 0;
+  bool busy_ = false;
+  /// 次に送るのがチャンクのヘッダか
+  bool at_header_ = false;
+
+  auto ChunkCrc(std::size_t offset) const -> std::uint16_t {
+    auto size = std::min(segment::kChunkSize, size_ - offset);
+    return internal::Crc16::Compute(buffer_.data() + offset, size);
+  }
+
+  auto HeaderFrame(std::uint8_t *frame) const -> std::size_t {
+    if (offset_ == 0) {
+      frame[0] = segment::kMessageStart;
+      segment::PutU16(&frame[1], static_cast<std::uint16_t>(size_));
+      segment::PutU16(&frame[3], full_crc_);
+      segment::PutU16(&frame[5], ChunkCrc(0));
+      return 7;
+    }
+
+    frame[0] = segment::kChunkStart;
+    segment::PutU16(&frame[1],
+                    static_cast<std::uint16_t>(offset_ / segment::kChunkSize));
+    segment::PutU16(&frame[3], ChunkCrc(offset_));
+    return 5;
+  }
+
+ public:
+  /// @brief 前のメッセージをまだ送り終えていないか
+  auto Busy() const -> bool { return busy_; }
+
+  /// @brief 送るメッセージを内部のバッファへ写す
+  /// @return 送信中のメッセージがある，もしくは大きすぎる場合 false
+  auto Load(std::uint8_t const *data, std::size_t size) -> bool {
+    if (busy_ || MaxMessageSize < size) {
+      return false;
+    }
+
+    if (size != 0) {
+      std::memcpy(buffer_.data(), data, size);
+    }
+    size_ = size;
+    offset_ = 0;
+    full_crc_ = internal::Crc16::Compute(buffer_.data(), size);
+    busy_ = true;
+    at_header_ = true;
+
+    return true;
+  }
+
+  /// @brief 送信枠が空いている間，フレームを stream に渡す
+  /// @return メッセージを全て渡し終えた場合 true
+  template <typename Stream>
+  auto Pump(Stream &stream) -> bool {
+    std::uint8_t frame[StreamPayload::kMaxSize];
+
+    while (busy_ && stream.CanSend()) {
+      if (at_header_) {
+        stream.Send(frame, HeaderFrame(frame));
+        at_header_ = false;
+        busy_ = size_ != 0;
+        continue;
+      }
+
+      auto chunk_end = std::min(
+          size_, (offset_ / segment::kChunkSize + 1) * segment::kChunkSize);
+      auto size = std::min(StreamPayload::kMaxSize, chunk_end - offset_);
+      stream.Send(buffer_.data() + offset_, size);
+
+      offset_ += size;
+      busy_ = offset_ != size_;
+      at_header_ = busy_ && offset_ == chunk_end;
+    }
+
+    return !busy_;
+  }
+};
+
+struct ReassemblerStats {
+  /// 組み立てて渡したメッセージの数
+  std::uint32_t messages = 0;
+  std::uint32_t chunk_crc_errors = 0;
+  std::uint32_t full_crc_errors = 0;
+  /// バッファに収まらず捨てたメッセージの数
+  std::uint32_t oversized = 0;
+  /// 書式が崩れて次のメッセージの先頭まで読み飛ばした回数
+  std::uint32_t framing_errors = 0;
+};
+
+/// @brief フレームから予め確保したバッファへメッセージを組み立てるもの
+/// @details 誤りを見つけたメッセージは捨て，残りのフレームは書式に従って読み飛ばす．
+///  書式自体が崩れた場合は次の kMessageStart まで読み飛ばす
+/// @tparam MaxMessageSize 受け取れるメッセージの最大長
+template <std::size_t MaxMessageSize>
+class Reassembler {
+  enum class State : std::uint8_t {
+    /// kMessageStart を待っている
+    kIdle,
+    /// kChunkStart を待っている
+    kChunkHeader,
+    kData,
+  };
+
+  std::array<std::uint8_t, MaxMessageSize> buffer_{};
+  State state_ = State::kIdle;
+  std::size_t size_ = 0;
+  std::size_t offset_ = 0;
+  std::uint16_t full_crc_ = 0;
+  std::uint16_t chunk_crc_ = 0;
+  internal::Crc16 chunk_;
+  internal::Crc16 full_;
+  /// このメッセージで誤りを見つけた (残りは読み飛ばす)
+  bool failed_ = false;
+  /// 書式が崩れ，次の kMessageStart を探している
+  bool skipping_ = false;
+
+  ReassemblerStats stats_;
+
+  internal::SignalTx<std::span<std::uint8_t const>> rx_message_tx_{
+      std::make_shared<internal::Signal<std::span<std::uint8_t const>>>()};
+
+  void BeginChunk(std::uint16_t chunk_crc) {
+    chunk_crc_ = chunk_crc;
+    chunk_ = {};
+    state_ = State::kData;
+  }
+
+  void EndChunk() {
+    if (!failed_ && chunk_.Get() != chunk_crc_) {
+      stats_.chunk_crc_errors++;
+      failed_ = true;
+    }
+
+    if (offset_ != size_) {
+      state_ = State::kChunkHeader;
+      return;
+    }
+
+    state_ = State::kIdle;
+    if (failed_) {
+      return;
+    }
+
+    if (full_.Get() != full_crc_) {
+      stats_.full_crc_errors++;
+      return;
+    }
+
+    stats_.messages++;
+    rx_message_tx_.Fire(std::span<std::uint8_t const>(buffer_.data(), size_));
+  }
+
+  void FramingError() {
+    if (!skipping_) {
+      stats_.framing_errors++;
+      skipping_ = true;
+    }
+    state_ = State::kIdle;
+  }
+
+ public:
+  /// @brief 組み立てたメッセージ (通知の間だけ有効)
+  internal::SignalRx<std::span<std::uint8_t const>> rx_message{rx_message_tx_};
+
+  void Feed(StreamPayload const &payload) {
+    auto const *data = payload.data.data();
+
+    switch (state_) {
+      case State::kIdle: {
+        if (payload.size != 7 || data[0] != segment::kMessageStart) {
+          FramingError();
+          return;
+        }
+
+        skipping_ = false;
+        size_ = segment::GetU16(&data[1]);
+        full_crc_ = segment::GetU16(&data[3]);
+        offset_ = 0;
+        full_ = {};
+        failed_ = MaxMessageSize < size_;
+        if (failed_) {
+          stats_.oversized++;
+        }
+
+        BeginChunk(segment::GetU16(&data[5]));
+        if (size_ == 0) {
+          EndChunk();
+        }
+        return;
+      }
+
+      case State::kChunkHeader: {
+        auto index = offset_ / segment::kChunkSize;
+        if (payload.size != 5 || data[0] != segment::kChunkStart ||
+            segment::GetU16(&data[1]) != index) {
+          FramingError();
+          if (payload.size == 7 && data[0] == segment::kMessageStart) {
+            // 送信側がメッセージを途中で打ち切った
+            Feed(payload);
+          }
+          return;
+        }
+
+        BeginChunk(segment::GetU16(&data[3]));
+        return;
+      }
+
+      case State::kData: {
+        auto chunk_end = std::min(
+            size_, (offset_ / segment::kChunkSize + 1) * segment::kChunkSize);
+        auto expected = std::min(StreamPayload::kMaxSize, chunk_end - offset_);
+        if (payload.size != expected) {
+          FramingError();
+          return;
+        }
+
+        if (!failed_) {
+          std::memcpy(buffer_.data() + offset_, data, expected);
+        }
+        chunk_.Update(data, expected);
+        full_.Update(data, expected);
+        offset_ += expected;
+
+        if (offset_ == chunk_end) {
+          EndChunk();
+        }
+        return;
+      }
+    }
+  }
+
+  auto Stats() const -> ReassemblerStats const & { return stats_; }
+};
+
+/// @brief ControlStream 上で任意長のメッセージをやり取りするもの
+/// @details stream の tx_ready と rx_data に繋がるので，stream より先に破棄すること
+/// @tparam MaxMessageSize 送受信するメッセージの最大長
+/// @tparam MaxWindow ControlStream の MaxWindow
+template <std::size_t MaxMessageSize = 256, std::size_t MaxWindow = 32>
+class MessageStream {
+  ControlStream<MaxWindow> &stream_;
+  Segmenter<MaxMessageSize> segmenter_;
+  Reassembler<MaxMessageSize> reassembler_;
+
+  internal::SignalConnection<std::uint8_t> tx_ready_connection_;
+  internal::SignalConnection<StreamPayload> rx_data_connection_;
+
+ public:
+  /// @brief 組み立てたメッセージ (通知の間だけ有効)
+  internal::SignalRx<std::span<std::uint8_t const>> rx_message{
+      reassembler_.rx_message};
+
+  explicit MessageStream(ControlStream<MaxWindow> &stream) : stream_(stream) {
+    tx_ready_connection_ =
+        stream_.tx_ready.Connect([this](std::uint8_t) { Pump(); });
+    rx_data_connection_ = stream_.rx_data.Connect(
+        [this](StreamPayload const &payload) { reassembler_.Feed(payload); });
+  }
+
+  MessageStream(MessageStream const &) = delete;
+  MessageStream &operator=(MessageStream const &) = delete;
+
+  ~MessageStream() {
+    tx_ready_connection_.Disconnect();
+    rx_data_connection_.Disconnect();
+  }
+
+  /// @brief メッセージを送る (送信枠に収まらない分は確認を受け取るたびに送る)
+  /// @return 前のメッセージを送り終えていない，もしくは大きすぎる場合 false
+  auto Send(std::uint8_t const *data, std::size_t size) -> bool {
+    if (!segmenter_.Load(data, size)) {
+      return false;
+    }
+
+    Pump();
+    return true;
+  }
+
+  /// @brief 次のメッセージを Send() できるか
+  auto CanSend() const -> bool { return !segmenter_.Busy(); }
+
+  /// @brief 送りかけのメッセージの残りを送信枠が空いている分だけ送る
+  void Pump() { segmenter_.Pump(stream_); }
+
+  auto Stats() const -> ReassemblerStats const & {
+    return reassembler_.Stats();
+  }
+};
+}  // namespace robobus::stream
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <array>
+#include <span>
+#include <type_traits>
+
+namespace robobus::types {
+/**
+ * @brief CAN フレームの属性
+ */
+enum class CanFrameFlags : uint8_t {
+  kNone = 0,
+  /// 29bit の拡張 ID
+  kExtended = 1 << 0,
+  /// リモートフレーム
+  kRemote = 1 << 1,
+  /// CAN FD フレーム
+  kFd = 1 << 2,
+  /// CAN FD のビットレートスイッチ
+  kBitrateSwitch = 1 << 3,
+  /// エラーフレーム (受信時のみ)
+  kError = 1 << 4,
+};
+
+constexpr CanFrameFlags operator|(CanFrameFlags lhs, CanFrameFlags rhs) {
+  return static_cast<CanFrameFlags>(static_cast<uint8_t>(lhs) |
+                                    static_cast<uint8_t>(rhs));
+}
+
+constexpr bool HasFlag(CanFrameFlags flags, CanFrameFlags flag) {
+  return (static_cast<uint8_t>(flags) & static_cast<uint8_t>(flag)) != 0;
+}
+
+/// @brief 標準 ID (11bit) の最大値
+constexpr uint32_t kMaxStandardCanId = 0x7FF;
+
+/**
+ * @brief ID の値から IDE (kExtended) を推測する
+ * @details IDE を伝えない CANBase との間で使う．kMaxStandardCanId を超える
+ *  ID は拡張 ID とみなす (拡張 ID で 0x7FF 以下のものは標準 ID になる)
+ */
+constexpr CanFrameFlags InferFlagsFromId(uint32_t id) {
+  return kMaxStandardCanId < id ? CanFrameFlags::kExtended
+                                : CanFrameFlags::kNone;
+}
+
+/**
+ * @brief CAN FD の DLC (0〜15) をデータ長に変換
+ */
+constexpr uint8_t CanDlcToLength(uint8_t dlc) {
+  constexpr uint8_t kLength[16] = {0,  1,  2,  3,  4,  5,  6,  7,
+                                   8, 12, 16, 20, 24, 32, 48, 64};
+  return kLength[dlc & 0x0F];
+}
+
+/**
+ * @brief データ長を収められる最小の CAN FD の DLC に変換
+ */
+constexpr uint8_t CanLengthToDlc(size_t length) {
+  if (length <= 8) return static_cast<uint8_t>(length);
+  if (length <= 12) return 9;
+  if (length <= 16) return 10;
+  if (length <= 20) return 11;
+  if (length <= 24) return 12;
+  if (length <= 32) return 13;
+  if (length <= 48) return 14;
+  return 15;
+}
+
+/**
+ * @class BasicCanFrame
+ * @brief データを内部に持つ CAN フレーム
+ * @details trivially copyable なので，ISR からキューへそのまま複製して渡せる．
+ *  受け取る側は Data() で std::span として参照する
+ * @tparam Capacity データの最大長 (CAN は 8, CAN FD は 64)
+ */
+template <size_t Capacity>
+struct BasicCanFrame {
+  static_assert(Capacity <= 64);
+
+  static constexpr size_t kCapacity = Capacity;
+
+  /// @brief 11bit もしくは 29bit の ID
+  uint32_t id;
+  CanFrameFlags flags;
+  /// @brief データ長 [byte] (DLC ではない)
+  uint8_t size;
+  std::array<uint8_t, Capacity> data;
+
+  /**
+   * @brief データを写してフレームを作る
+   * @details Capacity を超えた分は切り捨てる
+   */
+  static BasicCanFrame Create(uint32_t id, std::span<uint8_t const> data,
+                              CanFrameFlags flags = CanFrameFlags::kNone) {
+    BasicCanFrame frame;
+    frame.id = id;
+    frame.flags = flags;
+    frame.size =
+        static_cast<uint8_t>(data.size() < Capacity ? data.size() : Capacity);
+    if (frame.size != 0) {
+      std::memcpy(frame.data.data(), data.data(), frame.size);
+    }
+
+    return frame;
+  }
+
+  std::span<uint8_t const> Data() const { return {data.data(), size}; }
+
+  std::span<uint8_t> Data() { return {data.data(), size}; }
+
+  bool IsExtended() const { return HasFlag(flags, CanFrameFlags::kExtended); }
+
+  bool IsFd() const { return HasFlag(flags, CanFrameFlags::kFd); }
+};
+
+/// @brief Classic CAN のフレーム (最大 8 バイト)
+using CanFrame = BasicCanFrame<8>;
+
+/// @brief CAN FD のフレーム (最大 64 バイト)
+using CanFdFrame = BasicCanFrame<64>;
+
+static_assert(std::is_trivially_copyable_v<CanFrame>);
+static_assert(std::is_trivially_copyable_v<CanFdFrame>);
+static_assert(sizeof(CanFrame) == 16);
+}  // namespace robobus::types
@@ -40,6 +40,14 @@ class MessageID {
                      static_cast<uint32_t>(data_ctrl_marker));
   }
 
+  /// @brief Multicast の Message ID を生成
+  static MessageID CreateMulticast(MulticastSessionID session_id,
+                                   DeviceID sender_device_id) {
+    return MessageID((0x3 << 16) |
+                     (session_id.GetMulticastSessionID() << 8) |
+                     sender_device_id.GetDeviceID());
+  }
+
   /// @brief Message ID を取得
   uint32_t GetMsgID() const { return id_; }
 
@@ -0,0 +1,124 @@
+"""Decoder for the robobus DebugChannel binary stream.
+
+A batch is `'R' 'D' u8 version u16 body_len` followed by records
+(little endian). See robobus/debug/debug_channel.hpp for the layout.
+"""
+
+import struct
+import sys
+from dataclasses import dataclass
+from typing import BinaryIO, Iterator
+
+NO_CONTEXT = 0xFFFF
+VERSION = 3
+
+KIND_REGISTER = 1
+KIND_TEXT = 2
+KIND_INT = 3
+KIND_FLOAT = 4
+KIND_BYTES = 5
+KIND_DROPPED = 6
+
+
+@dataclass
+class DebugRecord:
+    path: str
+    time_us: int
+    value: int | float | bytes | str
+
+
+class DebugChannelDecoder:
+    def __init__(self):
+        self.contexts: dict[int, tuple[int, str]] = {}
+        self.dropped = 0
+
+    def path(self, key: int) -> str:
+        parts = []
+        while key != NO_CONTEXT:
+            if key not in self.contexts:
+                parts.append(f"#{key}")
+                break
+
+            key, tag = self.contexts[key]
+            parts.append(tag)
+
+        return ".".join(reversed(parts))
+
+    def decode_batch(self, batch: bytes) -> Iterator[DebugRecord]:
+        if len(batch) < 5 or batch[0:2] != b"RD":
+            raise ValueError("Not a DebugChannel batch")
+
+        if batch[2] != VERSION:
+            raise ValueError(f"Unsupported DebugChannel version: {batch[2]}")
+
+        (length,) = struct.unpack_from("<H", batch, 3)
+        body = batch[5 : 5 + length]
+
+        pos = 0
+        while pos < len(body):
+            kind = body[pos]
+            pos += 1
+
+            if kind == KIND_REGISTER:
+                key, parent, size = struct.unpack_from("<HHB", body, pos)
+                pos += 5
+                self.contexts[key] = (parent, body[pos : pos + size].decode())
+                pos += size
+                continue
+
+            if kind == KIND_DROPPED:
+                (count,) = struct.unpack_from("<I", body, pos)
+                pos += 4
+                self.dropped += count
+                continue
+
+            key, time_us = struct.unpack_from("<HI", body, pos)
+            pos += 6
+
+            if kind == KIND_INT:
+                (value,) = struct.unpack_from("<i", body, pos)
+                pos += 4
+            elif kind == KIND_FLOAT:
+                (value,) = struct.unpack_from("<f", body, pos)
+                pos += 4
+            elif kind == KIND_TEXT:
+                size = body[pos]
+                value = bytes(body[pos + 1 : pos + 1 + size]).decode(
+                    errors="replace"
+                )
+                pos += 1 + size
+            elif kind == KIND_BYTES:
+                size = body[pos]
+                value = bytes(body[pos + 1 : pos + 1 + size])
+                pos += 1 + size
+            else:
+                raise ValueError(f"Unknown record kind: {kind}")
+
+            yield DebugRecord(self.path(key), time_us, value)
+
+    def decode_stream(self, stream: BinaryIO) -> Iterator[DebugRecord]:
+        """Decodes `$1$bin$<len><batch>$` envelopes, skipping other lines."""
+
+        while line_head := stream.read(1):
+            if line_head != b"$":
+                continue
+
+            header = stream.read(6)
+            if header != b"1$bin$":
+                stream.readline()
+                continue
+
+            digits = b""
+            while (c := stream.read(1)).isdigit():
+                digits += c
+
+            batch = c + stream.read(int(digits) - 1)
+            stream.read(1)  # trailing '$'
+
+            yield from self.decode_batch(batch)
+
+
+if __name__ == "__main__":
+    decoder = DebugChannelDecoder()
+    for record in decoder.decode_stream(sys.stdin.buffer):
+        print(f"{record.time_us / 1e6:10.6f} {record.path}: {record.value!r}")
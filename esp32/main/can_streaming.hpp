@@ -76,7 +76,8 @@ class CANStreamingService : public ble::gatt::Service {
              .SetProperties(ble::gatt::chararacteristic::Prop::kNotify)  //
              .SetValue(bus_rx_val);
 
-    can_driver->OnRx([this](std::uint16_t op, std::vector<std::uint8_t> data) {
+    can_driver->OnRx([this](std::uint16_t op,
+                            std::vector<std::uint8_t> const &data) {
       bus_rx_val.op = op;
       bus_rx_val.len = data.size();
       std::copy(data.begin(), data.end(), bus_rx_val.data);
@@ -80,7 +80,7 @@ class CanDebug {
 
   void Init() {
     InitScreen();
-    can_.OnRx([this](uint32_t id, std::vector<uint8_t> data) {
+    can_.OnRx([this](uint32_t id, std::vector<uint8_t> const& data) {
       if (messages_.find(id) == messages_.end()) {
         messages_[id] = CanMessageData();
         messages_count_++;
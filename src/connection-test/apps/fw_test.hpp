@@ -33,9 +33,15 @@ class SimpleLogSink : public robotics::logger::LogSink {
 
 class SimpleDebugAdapter : public DebugAdapter {
  public:
-  void Message(std::string_view path, std::string_view text) override {
-    std::cout << fmt::format("$1$dbg${:d}{:s}${:d}{:s}$\n", path.size(), path,
-                             text.size(), text);
+  void RegisterContext(robobus::context::ContextID id,
+                       robobus::context::ContextID parent,
+                       std::string_view tag) override {
+    std::cout << fmt::format("$1$ctx${:d}${:d}${:d}{:s}$\n", id, parent,
+                             tag.size(), tag);
+  }
+
+  void Message(robobus::context::ContextID id, std::string_view text) override {
+    std::cout << fmt::format("$1$dbg${:d}${:d}{:s}$\n", id, text.size(), text);
   }
 };
 
@@ -46,7 +52,7 @@ Coroutine<void> Task(SharedContext<Clock> ctx,
 
   logger.RenameTag("   Test  ");
 
-  logger.Info("Started 'Task' (cid = %s)", ctx.ContextId().c_str());
+  logger.Info("Started 'Task' (cid = %s)", ctx.Path());
 
   co_await ctx.Sleep(delay);
 
@@ -0,0 +1,45 @@
+#include <chrono>
+
+#include <logger/logger.hpp>
+
+#include "test_clock.hpp"
+#include "bench_resume.hpp"
+#include "bench_frame_pool.hpp"
+#include "bench_await.hpp"
+#include "bench_can_frame.hpp"
+#include "bench_isr_queue.hpp"
+#include "bench_executor.hpp"
+#include "bench_debug_channel.hpp"
+#include "bench_context.hpp"
+#include "bench_control_stream.hpp"
+#include "bench_router.hpp"
+#include "bench_multicast.hpp"
+#include "bench_signal.hpp"
+#include "bench_virtual_clock.hpp"
+#include "bench_virtual_can.hpp"
+#include "bench_socket_can.hpp"
+
+using Clock = TestClock;
+
+int main() {
+  robotics::logger::core::Init();
+  robotics::logger::SuppressLogger("loop.robobus");
+
+  bench::frame_pool::Run<Clock>();
+  bench::resume::Run<Clock>();
+  bench::context::Run<Clock>();
+  bench::virtual_clock::Run();
+  bench::await::Run();
+  bench::isr_queue::Run<Clock>();
+  bench::executor::Run<Clock>();
+  bench::debug_channel::Run<Clock>();
+  bench::signal::Run();
+  bench::can_frame::Run();
+  bench::virtual_can::Run();
+  bench::control_stream::Run();
+  bench::router::Run();
+  bench::multicast::Run();
+  bench::socket_can::Run();
+
+  return 0;
+}
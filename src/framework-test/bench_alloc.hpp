@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <atomic>
+#include <new>
+
+namespace bench::alloc {
+/// @brief プログラム全体の operator new の呼び出し回数
+inline std::atomic<std::uint64_t> allocations{0};
+
+inline auto Count() -> std::uint64_t {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+/// @brief 数えてから確保する (失敗した場合 nullptr)
+inline auto Allocate(std::size_t size) noexcept -> void* {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+/// @brief 数えてから alignment に揃えて確保する (失敗した場合 nullptr)
+inline auto Allocate(std::size_t size, std::align_val_t alignment) noexcept
+    -> void* {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  // aligned_alloc の大きさは alignment の倍数でなければならない
+  auto align = static_cast<std::size_t>(alignment);
+  size = (size == 0 ? 1 : size) + align - 1;
+  return std::aligned_alloc(align, size - size % align);
+}
+
+template <typename... Args>
+auto AllocateOrThrow(std::size_t size, Args... args) -> void* {
+  if (auto ptr = Allocate(size, args...)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+}  // namespace bench::alloc
+
+// メモリ確保の回数を数えるため，グローバルの operator new/delete を一揃い置き換える
+// (framework-bench の翻訳単位は bench.cpp のみ)．配列と alignment 付きの確保も数える
+void* operator new(std::size_t size) {
+  return bench::alloc::AllocateOrThrow(size);
+}
+
+void* operator new[](std::size_t size) {
+  return bench::alloc::AllocateOrThrow(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return bench::alloc::AllocateOrThrow(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return bench::alloc::AllocateOrThrow(size, alignment);
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept {
+  return bench::alloc::Allocate(size);
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept {
+  return bench::alloc::Allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment,
+                   std::nothrow_t const&) noexcept {
+  return bench::alloc::Allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment,
+                     std::nothrow_t const&) noexcept {
+  return bench::alloc::Allocate(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::nothrow_t const&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::nothrow_t const&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t,
+                     std::nothrow_t const&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t,
+                       std::nothrow_t const&) noexcept {
+  std::free(ptr);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+
+#include <fmt/format.h>
+
+#include <robobus/coroutine/coroutine.hpp>
+#include <robobus/coroutine/task.hpp>
+
+namespace bench::await {
+using robobus::coroutine::Coroutine;
+using robobus::coroutine::Task;
+
+/// @brief 末端のコルーチンを一時停止させ，計測側から再開させるための awaiter
+struct Park {
+  static inline std::coroutine_handle<> parked;
+
+  bool await_ready() const { return false; }
+  void await_suspend(std::coroutine_handle<> handle) { parked = handle; }
+  void await_resume() const {}
+};
+
+Coroutine<int> EagerChain(int depth) {
+  if (depth == 0) {
+    co_await Park{};
+    co_return 1;
+  }
+
+  co_return co_await EagerChain(depth - 1) + 1;
+}
+
+Task<int> LazyChain(int depth) {
+  if (depth == 0) {
+    co_await Park{};
+    co_return 1;
+  }
+
+  co_return co_await LazyChain(depth - 1) + 1;
+}
+
+Coroutine<void> DriveEager(int depth, int& result) {
+  result = co_await EagerChain(depth);
+}
+
+Coroutine<void> DriveLazy(int depth, int& result) {
+  result = co_await LazyChain(depth);
+}
+
+/// @brief 深さ depth の co_await の連鎖を iterations 回完了させる時間を計測
+template <typename Start>
+auto Measure(int iterations, int depth, Start&& start) -> double {
+  int result = 0;
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    start(depth, result);
+    Park::parked.resume();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+
+  if (result != depth + 1) {
+    fmt::print("await: unexpected result {} (depth={})\n", result, depth);
+  }
+
+  auto elapsed_ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  return elapsed_ns / iterations / (depth + 1);
+}
+
+/// @brief Coroutine<T> と Task<T> の co_await 1 段あたりの時間を比較
+void Run() {
+  const int kAwaits = 200000;
+
+  for (int depth : {1, 10, 100, 1000}) {
+    auto iterations = kAwaits / depth;
+
+    auto eager = Measure(iterations, depth, [](int depth, int& result) {
+      DriveEager(depth, result);
+    });
+    auto lazy = Measure(iterations, depth, [](int depth, int& result) {
+      DriveLazy(depth, result);
+    });
+
+    fmt::print("await: depth={:5d} Coroutine<T> {:7.2f} ns/await  "
+               "Task<T> {:7.2f} ns/await\n",
+               depth, eager, lazy);
+  }
+}
+}  // namespace bench::await
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <robobus/can/can_bus.hpp>
+#include <types/can_frame.hpp>
+
+#include "bench_alloc.hpp"
+
+namespace bench::can_frame {
+using robobus::types::CanFrame;
+using robobus::types::CanFrameFlags;
+
+constexpr std::uint32_t kFrames = 1000000;
+
+/// @brief 受信メールボックスの内容 (ドライバが ISR で読み出すもの)
+struct Mailbox {
+  std::uint32_t id;
+  std::array<std::uint8_t, 8> data;
+  std::uint8_t size;
+};
+
+/// @brief 以前の CANBase と同じく std::vector でフレームを受け渡すもの
+class LegacyBus {
+  std::function<void(std::uint32_t, std::vector<std::uint8_t> const&)> rx_;
+
+ public:
+  std::uint64_t tx_checksum = 0;
+
+  void OnRx(std::function<void(std::uint32_t,
+                               std::vector<std::uint8_t> const&)> rx) {
+    rx_ = std::move(rx);
+  }
+
+  auto Send(std::uint32_t id, std::vector<std::uint8_t> const& data) -> int {
+    tx_checksum += id + data.size();
+    return 1;
+  }
+
+  void Receive(Mailbox const& mailbox) {
+    std::vector<std::uint8_t> data(mailbox.data.begin(),
+                                   mailbox.data.begin() + mailbox.size);
+    rx_(mailbox.id, data);
+  }
+};
+
+/// @brief CanFrame を値のまま受け渡すもの
+class FrameBus : public robobus::can::CanBus {
+ public:
+  std::uint64_t tx_checksum = 0;
+
+  auto Send(CanFrame const& frame) -> bool override {
+    tx_checksum += frame.id + frame.size;
+    return true;
+  }
+
+  void Receive(Mailbox const& mailbox) {
+    Deliver(CanFrame::Create(mailbox.id,
+                             std::span(mailbox.data.data(), mailbox.size),
+                             CanFrameFlags::kExtended));
+  }
+};
+
+struct Result {
+  double ns_per_frame;
+  double allocs_per_frame;
+};
+
+/// @brief 受信したフレームを見て確認フレームを 1 つ送り返す
+///  (ControlStreamOnCAN の受信から送信までを模したもの) 経路を測る
+template <typename F>
+auto Measure(F&& receive) -> Result {
+  Mailbox mailbox{0x00101, {1, 2, 3, 4, 5, 6, 7, 8}, 8};
+
+  auto allocations = alloc::Count();
+  auto begin = std::chrono::steady_clock::now();
+  for (std::uint32_t i = 0; i < kFrames; i++) {
+    mailbox.data[0] = i & 0xFF;
+    receive(mailbox);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+  allocations = alloc::Count() - allocations;
+
+  return Result{
+      .ns_per_frame =
+          std::chrono::duration<double, std::nano>(elapsed).count() / kFrames,
+      .allocs_per_frame = static_cast<double>(allocations) / kFrames,
+  };
+}
+
+void Print(const char* name, Result const& result, std::uint64_t checksum) {
+  fmt::print(
+      "can_frame: {:6s} frames={:d} {:6.1f} ns/frame  allocs/frame={:.2f} "
+      "(checksum={:d})\n",
+      name, kFrames, result.ns_per_frame, result.allocs_per_frame, checksum);
+}
+
+/// @brief std::vector と CanFrame で，受信から応答の送信までのメモリ確保を比べる
+void Run() {
+  {
+    LegacyBus bus;
+    std::uint64_t rx_checksum = 0;
+    bus.OnRx([&bus, &rx_checksum](std::uint32_t id,
+                                  std::vector<std::uint8_t> const& data) {
+      rx_checksum += data[0];
+
+      std::vector<std::uint8_t> ack(5);
+      ack[0] = data[0];
+      bus.Send(id ^ 1, ack);
+    });
+
+    auto result = Measure([&bus](Mailbox const& mailbox) {
+      bus.Receive(mailbox);
+    });
+    Print("vector", result, rx_checksum + bus.tx_checksum);
+  }
+
+  {
+    FrameBus bus;
+    std::uint64_t rx_checksum = 0;
+    bus.rx.Connect([&bus, &rx_checksum](CanFrame const& frame) {
+      rx_checksum += frame.data[0];
+
+      std::uint8_t ack[5] = {frame.data[0]};
+      bus.Send(CanFrame::Create(frame.id ^ 1, ack, frame.flags));
+    });
+
+    auto result = Measure([&bus](Mailbox const& mailbox) {
+      bus.Receive(mailbox);
+    });
+    Print("frame", result, rx_checksum + bus.tx_checksum);
+  }
+}
+}  // namespace bench::can_frame
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+
+#include <chrono>
+#include <memory>
+
+#include <fmt/format.h>
+
+#include <robobus/context/context.hpp>
+#include <robobus/coroutine/coroutine.hpp>
+#include <robobus/runtime/loop.hpp>
+#include <robobus/runtime/sleep.hpp>
+
+namespace bench::context {
+using robobus::coroutine::Coroutine;
+using robobus::runtime::Loop;
+
+constexpr std::uint64_t kTasks = 200000;
+constexpr std::uint64_t kSleeps = 1000000;
+constexpr std::uint64_t kLookups = 10000000;
+
+/// @brief 以前の SharedContext と同じく，shared_ptr で共有した Context から
+///  weak_ptr を lock() して Loop に辿り着くハンドル
+template <typename Clock>
+class LegacyContext {
+  struct Root {
+    Loop<Clock> loop;
+  };
+
+  struct Context {
+    std::weak_ptr<Root> root;
+  };
+
+  std::shared_ptr<Context> ctx_;
+
+ public:
+  explicit LegacyContext(std::shared_ptr<Root> root)
+      : ctx_(std::make_shared<Context>(Context{root})) {}
+
+  static auto MakeRoot() { return std::make_shared<Root>(); }
+
+  auto GetLoop() -> Loop<Clock>& { return ctx_->root.lock()->loop; }
+
+  auto Sleep(std::chrono::milliseconds duration) {
+    return robobus::runtime::Sleep(GetLoop(), duration);
+  }
+
+  template <typename Promise>
+  void AddTask(std::coroutine_handle<Promise> coroutine) {
+    ctx_->root.lock()->loop.AddTask(coroutine);
+  }
+};
+
+/// @brief 一度だけ Sleep して終了する短命なタスク (Context は値で受け取る)
+template <typename Ctx>
+Coroutine<void> ShortTask(Ctx ctx, std::uint64_t& finished) {
+  co_await ctx.Sleep(std::chrono::milliseconds::zero());
+  finished++;
+}
+
+/// @brief Sleep を繰り返すタスク
+template <typename Ctx>
+Coroutine<void> SleepLoop(Ctx ctx, std::uint64_t& count) {
+  while (count < kSleeps) {
+    co_await ctx.Sleep(std::chrono::milliseconds::zero());
+    count++;
+  }
+}
+
+template <typename Clock, typename Ctx>
+void Measure(const char* name, Ctx ctx, Loop<Clock>& loop) {
+  const int kBurst = 16;
+
+  std::uint64_t spawned = 0;
+  std::uint64_t finished = 0;
+
+  auto begin = std::chrono::steady_clock::now();
+  while (finished < kTasks) {
+    for (int i = 0; i < kBurst && spawned < kTasks; i++, spawned++) {
+      ctx.AddTask(ShortTask(ctx, finished).handle);
+    }
+    loop.Poll();
+  }
+  auto spawn_elapsed = std::chrono::steady_clock::now() - begin;
+
+  std::uint64_t count = 0;
+  ctx.AddTask(SleepLoop(ctx, count).handle);
+
+  begin = std::chrono::steady_clock::now();
+  while (count < kSleeps) {
+    loop.Poll();
+  }
+  auto sleep_elapsed = std::chrono::steady_clock::now() - begin;
+
+  // ハンドルの複製 (コルーチンへの受け渡し) と Loop への到達だけのコスト
+  Loop<Clock>* volatile sink = nullptr;
+  begin = std::chrono::steady_clock::now();
+  for (std::uint64_t i = 0; i < kLookups; i++) {
+    Ctx copy = ctx;
+    sink = &copy.GetLoop();
+  }
+  auto lookup_elapsed = std::chrono::steady_clock::now() - begin;
+  (void)sink;
+
+  using Nanos = std::chrono::duration<double, std::nano>;
+  fmt::print(
+      "context: {:6s} AddTask+Sleep {:6.1f} ns/task  Sleep {:6.1f} ns/sleep  "
+      "copy+GetLoop {:5.1f} ns\n",
+      name, Nanos(spawn_elapsed).count() / kTasks,
+      Nanos(sleep_elapsed).count() / kSleeps,
+      Nanos(lookup_elapsed).count() / kLookups);
+}
+
+/// @brief SharedContext (shared_ptr + weak_ptr::lock()) と ContextHandle での
+///  AddTask/Sleep のコストを比べる
+template <typename Clock>
+void Run() {
+  {
+    auto root = LegacyContext<Clock>::MakeRoot();
+    Measure<Clock>("legacy", LegacyContext<Clock>(root), root->loop);
+  }
+
+  {
+    robobus::context::SharedRootContext<Clock> root;
+    auto ctx = root.Child("bench");
+    Measure<Clock>("handle", ctx, root.GetLoop());
+  }
+}
+}  // namespace bench::context
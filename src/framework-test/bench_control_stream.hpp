@@ -0,0 +1,433 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <robobus/can/virtual_can_bus.hpp>
+#include <robobus/router/message_router.hpp>
+#include <robobus/stream/control_stream_on_can.hpp>
+#include <robobus/stream/message_stream.hpp>
+
+namespace bench::control_stream {
+using robobus::stream::ControlStream;
+using robobus::stream::ControlStreamConfig;
+using robobus::stream::ControlStreamOnCAN;
+using robobus::stream::MessageStream;
+using robobus::stream::ReassemblerStats;
+using robobus::stream::StreamFrame;
+using robobus::stream::StreamPayload;
+
+using robobus::types::DataCtrlMarker;
+using robobus::types::DeviceID;
+using robobus::types::MessageID;
+
+/// @brief 仮想 CAN バスに繋いだ 2 つの ControlStreamOnCAN
+/// @details b は RecreateB() で作り直せる (受信側の再起動)
+struct Link {
+  robobus::can::VirtualCanBus bus;
+  ControlStreamOnCAN<32> a;
+  ControlStreamOnCAN<32>::Config b_config;
+  std::optional<ControlStreamOnCAN<32>> b;
+
+  static auto Id(DataCtrlMarker marker) -> MessageID {
+    return MessageID::CreateControlTransfer(DeviceID(1), marker);
+  }
+
+  static auto Router(robobus::can::VirtualCanBus &bus)
+      -> std::shared_ptr<robobus::router::MessageRouter> {
+    return std::make_shared<robobus::router::MessageRouter>(bus.Attach());
+  }
+
+  Link(ControlStreamConfig config, robobus::can::VirtualCanBusConfig bus_config)
+      : bus(bus_config),
+        a({.router = Router(bus),
+           .tx_ctrl_msg_id = Id(DataCtrlMarker::kServerCtrl),
+           .rx_ctrl_msg_id = Id(DataCtrlMarker::kClientCtrl),
+           .tx_data_msg_id = Id(DataCtrlMarker::kServerData),
+           .rx_data_msg_id = Id(DataCtrlMarker::kClientData),
+           .stream = config}),
+        b_config({.router = Router(bus),
+                  .tx_ctrl_msg_id = Id(DataCtrlMarker::kClientCtrl),
+                  .rx_ctrl_msg_id = Id(DataCtrlMarker::kServerCtrl),
+                  .tx_data_msg_id = Id(DataCtrlMarker::kClientData),
+                  .rx_data_msg_id = Id(DataCtrlMarker::kServerData),
+                  .stream = config}) {
+    b.emplace(b_config);
+  }
+
+  /// @brief b を破棄して作り直す (rx_data への接続もやり直すこと)
+  void RecreateB() {
+    b.reset();
+    b.emplace(b_config);
+  }
+
+  /// @brief 1ms 進め，両端の Tick() を呼ぶ
+  void Step() {
+    bus.AdvanceBy(std::chrono::milliseconds(1));
+    a.Tick(1E-3f);
+    b->Tick(1E-3f);
+  }
+};
+
+struct Result {
+  double throughput_Bps;
+  double mean_latency_ms;
+  double max_latency_ms;
+  std::uint32_t retransmits;
+  double bus_load;
+  /// 期待した番号と異なるフレームを受け取った数 (欠けや重複，順序違い)
+  std::uint32_t out_of_order;
+};
+
+/// @brief A から B へ送れるだけ送り，duration の間に届いた量と遅延を測る
+auto Measure(ControlStreamConfig config,
+             robobus::can::VirtualCanBusConfig bus_config,
+             std::chrono::milliseconds duration) -> Result {
+  struct Record {
+    std::vector<std::chrono::nanoseconds> sent_at;
+    std::uint64_t received = 0;
+    std::uint32_t expected = 0;
+    std::uint32_t out_of_order = 0;
+    double latency_sum_us = 0;
+    double latency_max_us = 0;
+  };
+
+  Link link(config, bus_config);
+  Record record;
+
+  auto Feed = [&link, &record] {
+    std::uint8_t payload[StreamPayload::kMaxSize] = {};
+    while (link.a.CanSend()) {
+      auto index = static_cast<std::uint32_t>(record.sent_at.size());
+      std::memcpy(payload, &index, sizeof(index));
+      record.sent_at.push_back(link.bus.Now());
+      link.a.Send(payload, sizeof(payload));
+    }
+  };
+  link.a.Stream().tx_ready.Connect([&Feed](std::uint8_t) { Feed(); });
+
+  link.b->rx_data.Connect([&link, &record](StreamPayload const& payload) {
+    std::uint32_t index;
+    std::memcpy(&index, payload.data.data(), sizeof(index));
+    if (index != record.expected++ || record.sent_at.size() <= index) {
+      record.out_of_order++;
+      record.expected = index + 1;
+      return;
+    }
+
+    auto latency = std::chrono::duration<double, std::micro>(
+                       link.bus.Now() - record.sent_at[index])
+                       .count();
+    record.latency_sum_us += latency;
+    if (record.latency_max_us < latency) {
+      record.latency_max_us = latency;
+    }
+    record.received++;
+  });
+
+  for (auto t = std::chrono::milliseconds(0); t < duration; t++) {
+    Feed();
+    link.Step();
+  }
+
+  auto seconds = std::chrono::duration<double>(duration).count();
+  auto received = static_cast<double>(record.received);
+  return Result{
+      .throughput_Bps = received * StreamPayload::kMaxSize / seconds,
+      .mean_latency_ms =
+          record.received == 0 ? 0 : record.latency_sum_us / received / 1E3,
+      .max_latency_ms = record.latency_max_us / 1E3,
+      .retransmits = link.a.Stream().Stats().retransmits,
+      .bus_load = link.bus.BusLoad(),
+      .out_of_order = record.out_of_order,
+  };
+}
+
+struct RecreateResult {
+  /// 作り直してから最初のフレームを受け取るまでの時間
+  std::optional<std::chrono::nanoseconds> resumed_after;
+  /// 作り直した後に受け取ったフレームの数
+  std::uint64_t received;
+  /// 作り直す前に受け取っていない番号を飛ばした (もしくは順序が崩れた) 数
+  std::uint32_t out_of_order;
+  /// A が同期 (SYN) をやり直した回数 (最初の同期を含む)
+  std::uint32_t syncs;
+};
+
+/// @brief A から B へ送り続け，途中で B を作り直した後に受信が再開するかを確かめる
+/// @details 新しい B は同期要求 (Sync Request) を返し，A の SYN と B の SYN-ACK で
+///  同期し直す．A の確認待ちのフレームから送り直されるので，作り直す前に受け取って
+///  いた分と重なることはあっても，番号が飛ぶことはない
+auto MeasureRecreate(ControlStreamConfig config,
+                     robobus::can::VirtualCanBusConfig bus_config,
+                     std::chrono::milliseconds recreate_at,
+                     std::chrono::milliseconds duration) -> RecreateResult {
+  Link link(config, bus_config);
+
+  std::uint32_t sent = 0;
+  auto Feed = [&link, &sent] {
+    std::uint8_t payload[StreamPayload::kMaxSize] = {};
+    while (link.a.CanSend()) {
+      std::memcpy(payload, &sent, sizeof(sent));
+      link.a.Send(payload, sizeof(payload));
+      sent++;
+    }
+  };
+  link.a.Stream().tx_ready.Connect([&Feed](std::uint8_t) { Feed(); });
+
+  RecreateResult result{};
+  std::uint32_t expected = 0;
+  std::optional<std::chrono::nanoseconds> recreated_at;
+  auto Receive = [&link, &result, &expected,
+                  &recreated_at](StreamPayload const& payload) {
+    std::uint32_t index;
+    std::memcpy(&index, payload.data.data(), sizeof(index));
+
+    if (recreated_at && !result.resumed_after) {
+      // 作り直した直後は，前の B が受け取ったが確認していない分から始まる
+      result.resumed_after = link.bus.Now() - *recreated_at;
+      if (expected < index) {
+        result.out_of_order++;
+      }
+    } else if (index != expected) {
+      result.out_of_order++;
+    }
+    expected = index + 1;
+
+    if (recreated_at) {
+      result.received++;
+    }
+  };
+  link.b->rx_data.Connect(Receive);
+
+  for (auto t = std::chrono::milliseconds(0); t < duration; t++) {
+    if (t == recreate_at) {
+      link.RecreateB();
+      link.b->rx_data.Connect(Receive);
+      recreated_at = link.bus.Now();
+    }
+
+    Feed();
+    link.Step();
+  }
+
+  result.syncs = link.a.Stream().Stats().syncs;
+  return result;
+}
+
+/// @brief seq 番目のメッセージの内容 (受信側で同じものを作って比べる)
+void FillMessage(std::vector<std::uint8_t>& message, std::uint32_t seq) {
+  for (std::size_t i = 0; i < message.size(); i++) {
+    message[i] = static_cast<std::uint8_t>(seq * 31 + i);
+  }
+}
+
+/// @brief 誤りの数 (壊れたフレームが無ければすべて 0)
+auto Errors(ReassemblerStats const& stats) -> std::uint32_t {
+  return stats.chunk_crc_errors + stats.full_crc_errors + stats.oversized +
+         stats.framing_errors;
+}
+
+struct MessageResult {
+  double throughput_Bps;
+  /// 内容 (もしくは長さ) が送ったものと異なるメッセージの数
+  std::uint32_t mismatched;
+  ReassemblerStats stats;
+};
+
+/// @brief size バイトのメッセージを MessageStream で送れるだけ送り，
+///  duration の間に届いたメッセージの量 [B/s] を測る
+/// @details 届いたメッセージは送った順に中身を比べる
+auto MeasureMessages(std::size_t size,
+                     robobus::can::VirtualCanBusConfig bus_config,
+                     std::chrono::milliseconds duration) -> MessageResult {
+  Link link({.window = 8}, bus_config);
+
+  MessageStream<512> tx(link.a.Stream());
+  MessageStream<512> rx(link.b->Stream());
+
+  std::vector<std::uint8_t> message(size);
+  std::uint32_t sent = 0;
+
+  std::vector<std::uint8_t> expected(size);
+  std::uint32_t delivered = 0;
+  std::uint64_t received = 0;
+  std::uint32_t mismatched = 0;
+  rx.rx_message.Connect(
+      [&expected, &delivered, &received,
+       &mismatched](std::span<std::uint8_t const> message) {
+        FillMessage(expected, delivered++);
+        if (!std::equal(message.begin(), message.end(), expected.begin(),
+                        expected.end())) {
+          mismatched++;
+        }
+        received += message.size();
+      });
+
+  for (auto t = std::chrono::milliseconds(0); t < duration; t++) {
+    while (tx.CanSend()) {
+      FillMessage(message, sent++);
+      tx.Send(message.data(), message.size());
+    }
+    link.Step();
+  }
+
+  return MessageResult{
+      .throughput_Bps = static_cast<double>(received) /
+                        std::chrono::duration<double>(duration).count(),
+      .mismatched = mismatched,
+      .stats = rx.Stats(),
+  };
+}
+
+/// @brief データフレームを 1 つだけ壊し，チャンクの CRC で検出して
+///  そのメッセージだけを捨てるかを確かめる
+/// @details CAN を挟まずに 2 つの ControlStream を直接繋ぎ，
+///  最初のメッセージの 2 つ目のデータフレーム (チャンク内) の 1 bit を反転する
+void CorruptOneFrame() {
+  constexpr std::size_t kSize = 64;
+  constexpr std::uint32_t kMessages = 8;
+  constexpr std::uint32_t kCorruptedFrame = 2;
+
+  ControlStream<32> a({.window = 8});
+  ControlStream<32> b({.window = 8});
+  MessageStream<512> tx(a);
+  MessageStream<512> rx(b);
+
+  // Send() の中から相手を呼び返さないよう，フレームは一旦溜めて Step ごとに渡す
+  std::vector<StreamFrame> a_to_b_data;
+  std::vector<StreamFrame> a_to_b_ctrl;
+  std::vector<StreamFrame> b_to_a_ctrl;
+  std::uint32_t data_frames = 0;
+  a.tx_data.Connect([&a_to_b_data, &data_frames](StreamFrame const& frame) {
+    auto copy = frame;
+    if (data_frames++ == kCorruptedFrame) {
+      copy.data[copy.size - 1] ^= 0x01;
+    }
+    a_to_b_data.push_back(copy);
+  });
+  a.tx_ctrl.Connect(
+      [&a_to_b_ctrl](StreamFrame const& frame) { a_to_b_ctrl.push_back(frame); });
+  b.tx_ctrl.Connect(
+      [&b_to_a_ctrl](StreamFrame const& frame) { b_to_a_ctrl.push_back(frame); });
+
+  std::vector<std::uint8_t> expected(kSize);
+  std::vector<std::uint32_t> delivered;
+  std::uint32_t mismatched = 0;
+  rx.rx_message.Connect([&expected, &delivered, &mismatched](
+                            std::span<std::uint8_t const> message) {
+    // 壊れた最初のメッセージは捨てられるので，届くのは 1 番目から
+    auto seq = static_cast<std::uint32_t>(delivered.size()) + 1;
+    FillMessage(expected, seq);
+    if (!std::equal(message.begin(), message.end(), expected.begin(),
+                    expected.end())) {
+      mismatched++;
+    }
+    delivered.push_back(seq);
+  });
+
+  std::vector<std::uint8_t> message(kSize);
+  std::uint32_t sent = 0;
+  for (int step = 0; step < 1000 && delivered.size() + 1 < kMessages; step++) {
+    if (sent < kMessages && tx.CanSend()) {
+      FillMessage(message, sent++);
+      tx.Send(message.data(), message.size());
+    }
+
+    for (auto& frame : std::exchange(a_to_b_ctrl, {})) {
+      b.LoadRxControlData(frame.data.data(), frame.size);
+    }
+    for (auto& frame : std::exchange(a_to_b_data, {})) {
+      b.FeedRxData(frame.data.data(), frame.size);
+    }
+    for (auto& frame : std::exchange(b_to_a_ctrl, {})) {
+      a.LoadRxControlData(frame.data.data(), frame.size);
+    }
+    a.Tick(1E-3f);
+    b.Tick(1E-3f);
+  }
+
+  auto const& stats = rx.Stats();
+  auto ok = stats.chunk_crc_errors == 1 && Errors(stats) == 1 &&
+            delivered.size() + 1 == kMessages && mismatched == 0;
+  fmt::print(
+      "control_stream: corrupt one frame  chunk_crc_errors={:d} errors={:d} "
+      "delivered={:d}/{:d} mismatched={:d} ok={}\n",
+      stats.chunk_crc_errors, Errors(stats), delivered.size(), kMessages,
+      mismatched, ok);
+}
+
+/// @brief 送信枠の大きさごとに，模擬 CAN バス上での転送速度と遅延を比べる
+void Run() {
+  constexpr auto kDuration = std::chrono::milliseconds(2000);
+  constexpr std::uint32_t kBitrate = 500000;
+  // 受信割り込みからアプリケーションが処理するまでの遅延
+  constexpr auto kRxLatency = std::chrono::microseconds(200);
+
+  for (auto loss_ppm : {0u, 10000u}) {
+    for (std::uint8_t window : {1, 4, 8, 16}) {
+      ControlStreamConfig config;
+      config.window = window;
+      config.ack_every = window < 2 ? 1 : window / 2;
+
+      auto result = Measure(
+          config,
+          {.bitrate = kBitrate, .loss_ppm = loss_ppm, .rx_latency = kRxLatency},
+          kDuration);
+      fmt::print(
+          "control_stream: loss={:4.1f}% window={:2d} {:7.0f} B/s  "
+          "latency mean={:5.2f} ms max={:6.2f} ms  retransmits={:5d}  "
+          "bus={:3.0f}%  out_of_order={:d} ok={}\n",
+          loss_ppm / 1E4, window, result.throughput_Bps,
+          result.mean_latency_ms, result.max_latency_ms, result.retransmits,
+          result.bus_load * 100, result.out_of_order,
+          result.out_of_order == 0);
+    }
+  }
+
+  // 転送の途中で受信側を作り直し，同期し直して受信が再開するか
+  for (auto loss_ppm : {0u, 10000u}) {
+    auto result = MeasureRecreate(
+        {.window = 8},
+        {.bitrate = kBitrate, .loss_ppm = loss_ppm, .rx_latency = kRxLatency},
+        kDuration / 2, kDuration);
+    auto resumed_ms =
+        result.resumed_after
+            ? std::chrono::duration<double, std::milli>(*result.resumed_after)
+                  .count()
+            : -1.0;
+    fmt::print(
+        "control_stream: loss={:4.1f}% recreate receiver  resumed after "
+        "{:5.2f} ms  received={:d} syncs={:d}  out_of_order={:d} ok={}\n",
+        loss_ppm / 1E4, resumed_ms, result.received, result.syncs,
+        result.out_of_order,
+        result.resumed_after.has_value() && result.received != 0 &&
+            2 <= result.syncs && result.out_of_order == 0);
+  }
+
+  // メッセージ単位 (チャンクのヘッダの分だけ window=8 の場合より少なくなる)
+  for (std::size_t size : {8, 64, 256, 512}) {
+    auto result = MeasureMessages(
+        size, {.bitrate = kBitrate, .rx_latency = kRxLatency}, kDuration);
+    fmt::print(
+        "control_stream: message size={:3d} {:7.0f} B/s  messages={:d} "
+        "mismatched={:d} errors={:d} ok={}\n",
+        size, result.throughput_Bps, result.stats.messages, result.mismatched,
+        Errors(result.stats),
+        result.stats.messages != 0 && result.mismatched == 0 &&
+            Errors(result.stats) == 0);
+  }
+
+  CorruptOneFrame();
+}
+}  // namespace bench::control_stream
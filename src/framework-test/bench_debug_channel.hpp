@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <chrono>
+#include <memory>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#include <robobus/debug/debug_adapter.hpp>
+#include <robobus/debug/debug_channel.hpp>
+#include <robobus/debug/debug_transport.hpp>
+
+namespace bench::debug_channel {
+using robobus::context::ContextID;
+using robobus::debug::DebugAdapter;
+using robobus::debug::DebugChannel;
+using robobus::debug::DebugTransport;
+
+constexpr std::uint32_t kValues = 1000000;
+/// 1 kHz の値を 100 ms ごとに書き出す想定
+constexpr std::uint32_t kValuesPerFlush = 100;
+/// 1 回の Flush() の間に ReportProfiles() が送る Context の数
+constexpr std::uint32_t kProfilesPerFlush = 16;
+
+struct Sink {
+  std::uint64_t writes = 0;
+  std::uint64_t bytes = 0;
+};
+
+/// @brief 書き出した回数とバイト数だけを数える Transport
+class CountingTransport : public DebugTransport {
+  Sink& sink_;
+
+ public:
+  explicit CountingTransport(Sink& sink) : sink_(sink) {}
+
+  void Write(std::uint8_t const*, std::size_t size) override {
+    sink_.writes++;
+    sink_.bytes += size;
+  }
+};
+
+/// @brief 以前の framework-test と同じく，メッセージごとに文字列を組み立てる Adapter
+class TextAdapter : public DebugAdapter {
+  Sink& sink_;
+
+ public:
+  explicit TextAdapter(Sink& sink) : sink_(sink) {}
+
+  void RegisterContext(ContextID, ContextID, std::string_view) override {}
+
+  void Message(ContextID id, std::string_view text) override {
+    auto line = fmt::format("$1$dbg${:d}${:d}{:s}$\n", id, text.size(), text);
+    sink_.writes++;
+    sink_.bytes += line.size();
+  }
+};
+
+template <typename F>
+void Measure(const char* name, Sink const& sink, F&& f) {
+  auto begin = std::chrono::steady_clock::now();
+  f();
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+
+  auto elapsed_ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  fmt::print(
+      "debug_channel: {:6s} values={:d} {:7.1f} ns/value  {:5.1f} B/value  "
+      "writes={:d}\n",
+      name, kValues, elapsed_ns / kValues,
+      static_cast<double>(sink.bytes) / kValues, sink.writes);
+}
+
+/// @brief 1 kHz のモーター電流を想定した実数値を，文字列と DebugChannel で送った時のコスト
+template <typename Clock>
+void Run() {
+  constexpr ContextID kKey = 3;
+
+  Sink text_sink;
+  TextAdapter text{text_sink};
+  Measure("text", text_sink, [&text] {
+    for (std::uint32_t i = 0; i < kValues; i++) {
+      text.Float(kKey, i * 0.001f);
+    }
+  });
+
+  Sink binary_sink;
+  auto channel = std::make_unique<DebugChannel<Clock>>(
+      std::make_unique<CountingTransport>(binary_sink));
+  channel->RegisterContext(kKey, robobus::context::kNoContext, "current");
+  Measure("binary", binary_sink, [&channel] {
+    for (std::uint32_t i = 0; i < kValues; i++) {
+      channel->Float(kKey, i * 0.001f);
+
+      if ((i + 1) % kValuesPerFlush == 0) {
+        channel->Flush();
+      }
+    }
+    channel->Flush();
+  });
+
+  if (channel->Dropped() != 0) {
+    fmt::print("debug_channel: dropped={:d}\n", channel->Dropped());
+  }
+
+  // 既定の容量で，値に加えて ReportProfiles() の 1 回分が捨てられずに収まるか
+  Sink burst_sink;
+  auto burst = std::make_unique<DebugChannel<Clock>>(
+      std::make_unique<CountingTransport>(burst_sink));
+  burst->RegisterContext(kKey, robobus::context::kNoContext, "current");
+  constexpr std::string_view kProfileLine =
+      "tasks=3 resumes=123456 run_total_us=12345.6 run_max_us=123.4 "
+      "late_mean_us=12.3 late_max_us=123.4";
+  Measure("burst", burst_sink, [&burst, kProfileLine] {
+    for (std::uint32_t i = 0; i < kValues; i++) {
+      burst->Float(kKey, i * 0.001f);
+
+      if ((i + 1) % kValuesPerFlush == 0) {
+        for (std::uint32_t j = 0; j < kProfilesPerFlush; j++) {
+          burst->Message(kKey, kProfileLine);
+        }
+        burst->Flush();
+      }
+    }
+    burst->Flush();
+  });
+
+  fmt::print("debug_channel: burst dropped={:d} ok={}\n", burst->Dropped(),
+             burst->Dropped() == 0);
+}
+}  // namespace bench::debug_channel
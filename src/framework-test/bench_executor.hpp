@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <robobus/coroutine/coroutine.hpp>
+#include <robobus/runtime/executor.hpp>
+#include <robobus/runtime/loop.hpp>
+#include <robobus/runtime/ticker.hpp>
+
+namespace bench::executor {
+using robobus::coroutine::Coroutine;
+using robobus::runtime::Executor;
+using robobus::runtime::Loop;
+using robobus::runtime::Ticker;
+
+constexpr int kNodes = 50;
+
+/// @brief 仮想ノード 1 台分 (1 ms 周期で少し計算する)
+template <typename Clock>
+struct Node {
+  Loop<Clock> loop;
+  std::uint64_t ticks = 0;
+  std::uint64_t overruns = 0;
+  std::uint64_t state = 1;
+  std::optional<Coroutine<void>> main;
+
+  /// @brief Ticker で止まっている Main() のフレームを Loop より先に破棄する
+  ~Node() {
+    if (main) {
+      main->handle.destroy();
+    }
+  }
+
+  Coroutine<void> Main() {
+    using namespace std::chrono_literals;
+
+    Ticker<Clock> tick{loop, 1ms};
+    while (true) {
+      co_await tick;
+
+      for (int i = 0; i < 2000; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      }
+      ticks++;
+      overruns = tick.Stats().overruns;
+    }
+  }
+};
+
+template <typename Clock>
+void Report(const char *name, std::vector<std::unique_ptr<Node<Clock>>> &nodes,
+            std::chrono::steady_clock::duration elapsed, double cpu_s) {
+  std::uint64_t ticks = 0;
+  std::uint64_t overruns = 0;
+  for (auto &node : nodes) {
+    ticks += node->ticks;
+    overruns += node->overruns;
+  }
+
+  auto elapsed_s = std::chrono::duration<double>(elapsed).count();
+  auto expected = kNodes * elapsed_s * 1E3;
+  fmt::print(
+      "executor: {:<16s} nodes={:d} ticks={:d} ({:5.1f}% of schedule) "
+      "overruns={:d} cpu={:.0f}%\n",
+      name, kNodes, ticks, 100 * ticks / expected, overruns,
+      100 * cpu_s / elapsed_s);
+}
+
+inline auto CpuTime() -> double {
+  return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+/// @brief ノードごとにスレッドを立てて Loop::RunFor() する従来の方法
+template <typename Clock>
+void RunThreadPerNode(std::chrono::milliseconds length) {
+  std::vector<std::unique_ptr<Node<Clock>>> nodes;
+  for (int i = 0; i < kNodes; i++) {
+    nodes.emplace_back(std::make_unique<Node<Clock>>());
+    nodes.back()->main = nodes.back()->Main();
+  }
+
+  auto cpu = CpuTime();
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (auto &node : nodes) {
+    threads.emplace_back([&node, length] { node->loop.RunFor(length); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+
+  Report("thread-per-node", nodes, elapsed, CpuTime() - cpu);
+}
+
+/// @brief 全ノードを Executor の N 本のワーカーで実行する
+template <typename Clock>
+void RunExecutor(std::chrono::milliseconds length) {
+  std::vector<std::unique_ptr<Node<Clock>>> nodes;
+  Executor<Clock> executor;
+  for (int i = 0; i < kNodes; i++) {
+    nodes.emplace_back(std::make_unique<Node<Clock>>());
+    nodes.back()->main = nodes.back()->Main();
+    executor.Add(nodes.back()->loop);
+  }
+
+  auto cpu = CpuTime();
+  auto begin = std::chrono::steady_clock::now();
+  executor.RunFor(length);
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+
+  auto stats = executor.GetStats();
+  Report(fmt::format("executor x{:d}", executor.WorkerCount()).c_str(), nodes,
+         elapsed, CpuTime() - cpu);
+  fmt::print("executor: polls={:d} steals={:d} sleeps={:d}\n", stats.polls,
+             stats.steals, stats.sleeps);
+}
+
+template <typename Clock>
+void Run() {
+  using namespace std::chrono_literals;
+
+  RunThreadPerNode<Clock>(1000ms);
+  RunExecutor<Clock>(1000ms);
+}
+}  // namespace bench::executor
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+#include <chrono>
+
+#include <fmt/format.h>
+
+#include <robobus/coroutine/coroutine.hpp>
+#include <robobus/coroutine/frame_pool.hpp>
+#include <robobus/runtime/loop.hpp>
+#include <robobus/runtime/sleep.hpp>
+
+namespace bench::frame_pool {
+using robobus::coroutine::Coroutine;
+using robobus::coroutine::FramePool;
+using robobus::runtime::Loop;
+
+/// @brief 一度だけ Sleep して終了する短命なタスク
+template <typename Clock>
+Coroutine<void> ShortTask(Loop<Clock>& loop, std::uint64_t& finished) {
+  co_await robobus::runtime::Sleep(loop, Clock::duration::zero());
+  finished++;
+}
+
+/// @brief 短命なタスクを生成・破棄し続けた時のフレーム確保の様子を計測
+template <typename Clock>
+void Run() {
+  const std::uint64_t kTasks = 200000;
+  const int kBurst = 16;
+
+  Loop<Clock> loop;
+  std::uint64_t spawned = 0;
+  std::uint64_t finished = 0;
+
+  auto before = FramePool::GetStats();
+  auto begin = std::chrono::steady_clock::now();
+  while (finished < kTasks) {
+    for (int i = 0; i < kBurst && spawned < kTasks; i++, spawned++) {
+      loop.AddTask(ShortTask(loop, finished).handle);
+    }
+    loop.Poll();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+  auto after = FramePool::GetStats();
+
+  auto elapsed_s = std::chrono::duration<double>(elapsed).count();
+  fmt::print(
+      "frame_pool: tasks={:d} {:8.3f} ms  {:12.0f} spawn/s, "
+      "block={:d}B largest={:d}B high_water={:d}/{:d} fallbacks={:d}\n",
+      kTasks, elapsed_s * 1E3, kTasks / elapsed_s, FramePool::kBlockSize,
+      after.largest_frame, after.high_water, FramePool::kBlocks,
+      after.fallbacks - before.fallbacks);
+}
+}  // namespace bench::frame_pool
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <robobus/coroutine/coroutine.hpp>
+#include <robobus/runtime/isr_queue.hpp>
+#include <robobus/runtime/loop.hpp>
+
+namespace bench::isr_queue {
+using robobus::coroutine::Coroutine;
+using robobus::runtime::IsrQueue;
+using robobus::runtime::Loop;
+
+constexpr int kProducers = 4;
+constexpr std::uint32_t kEventsPerProducer = 200000;
+
+struct Event {
+  std::uint32_t producer;
+  std::uint32_t seq;
+};
+
+struct Result {
+  std::uint64_t received = 0;
+  std::uint64_t out_of_order = 0;
+  std::array<std::uint32_t, kProducers> next_seq{};
+};
+
+template <typename Clock>
+using Queue = IsrQueue<Clock, Event, 64>;
+
+/// @brief 割り込みハンドラの代わりにイベントを積み続けるスレッド
+/// @details 満杯の場合は積み直すので，イベントは取りこぼされないはず
+template <typename Clock>
+void Producer(Queue<Clock>& queue, std::uint32_t producer,
+              std::uint64_t& retries) {
+  for (std::uint32_t seq = 0; seq < kEventsPerProducer; seq++) {
+    while (!queue.Post(Event{producer, seq})) {
+      retries++;
+      std::this_thread::yield();
+    }
+  }
+}
+
+template <typename Clock>
+Coroutine<void> Consumer(Queue<Clock>& queue, Result& result) {
+  while (result.received < kProducers * kEventsPerProducer) {
+    auto event = co_await queue.Next();
+
+    if (event.seq != result.next_seq[event.producer]) {
+      result.out_of_order++;
+    }
+    result.next_seq[event.producer] = event.seq + 1;
+    result.received++;
+  }
+}
+
+/// @brief 複数スレッドから IsrQueue へ同時に積み，Loop 上で順序と個数を検証する
+template <typename Clock>
+void Run() {
+  Loop<Clock> loop;
+  Queue<Clock> queue{loop};
+  Result result;
+
+  Consumer(queue, result);
+
+  std::vector<std::uint64_t> retries(kProducers);
+  std::vector<std::thread> producers;
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < kProducers; i++) {
+    producers.emplace_back(Producer<Clock>, std::ref(queue), i,
+                           std::ref(retries[i]));
+  }
+
+  loop.RunUntil(Clock::time_point::max());
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+
+  std::uint64_t total_retries = 0;
+  for (int i = 0; i < kProducers; i++) {
+    producers[i].join();
+    total_retries += retries[i];
+  }
+
+  auto elapsed_s = std::chrono::duration<double>(elapsed).count();
+  fmt::print(
+      "isr_queue: producers={:d} events={:d} {:8.3f} ms  {:12.0f} events/s, "
+      "out_of_order={:d} full_retries={:d} dropped={:d} ok={}\n",
+      kProducers, result.received, elapsed_s * 1E3,
+      result.received / elapsed_s, result.out_of_order, total_retries,
+      queue.Dropped(),
+      result.received == kProducers * kEventsPerProducer &&
+          result.out_of_order == 0);
+}
+}  // namespace bench::isr_queue
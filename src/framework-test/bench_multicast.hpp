@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <robobus/can/can_bus.hpp>
+#include <robobus/multicast/multicast_session.hpp>
+#include <robobus/router/message_router.hpp>
+
+#include "bench_alloc.hpp"
+
+namespace bench::multicast {
+using robobus::multicast::MulticastSample;
+using robobus::multicast::MulticastSession;
+using robobus::types::CanFrame;
+using robobus::types::CanFrameFlags;
+using robobus::types::DeviceID;
+using robobus::types::MulticastSessionID;
+
+constexpr std::uint32_t kSamples = 200000;
+
+/// @brief 車輪の速度 (1 フレームに収まるサンプル)
+struct WheelSpeed {
+  std::int16_t rpm[4];
+};
+
+/// @brief 受信したフレームを rx に流すだけのバス
+class InjectBus : public robobus::can::CanBus {
+ public:
+  auto Send(CanFrame const &) -> bool override { return true; }
+
+  void Inject(CanFrame const &frame) { Deliver(frame); }
+};
+
+struct Result {
+  double ns_per_sample;
+  double allocs_per_sample;
+};
+
+template <typename F>
+auto Measure(F &&step) -> Result {
+  auto allocations = alloc::Count();
+  auto begin = std::chrono::steady_clock::now();
+  for (std::uint32_t i = 0; i < kSamples; i++) {
+    step(i);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+  allocations = alloc::Count() - allocations;
+
+  return Result{
+      .ns_per_sample =
+          std::chrono::duration<double, std::nano>(elapsed).count() / kSamples,
+      .allocs_per_sample = static_cast<double>(allocations) / kSamples,
+  };
+}
+
+auto Frame(std::uint32_t i) -> CanFrame {
+  WheelSpeed sample{{static_cast<std::int16_t>(i), 0, 0, 0}};
+  std::uint8_t data[sizeof(WheelSpeed)];
+  std::memcpy(data, &sample, sizeof(sample));
+  // セッション 5, 送信元 1
+  return CanFrame::Create(3u << 16 | 5u << 8 | 1u, data,
+                          CanFrameFlags::kExtended);
+}
+
+/// @brief 購読者ごとに std::deque へ複製する方式と，
+///  MulticastSession の共有リングから参照で読む方式で，受信から全員が読むまでを比べる
+void Run() {
+  for (std::size_t subscribers : {1u, 4u, 16u}) {
+    std::uint64_t copy_checksum = 0;
+    Result copy;
+    {
+      auto bus = std::make_shared<InjectBus>();
+      std::vector<std::deque<MulticastSample<WheelSpeed>>> queues(subscribers);
+      robobus::router::MessageRouter router(bus);
+      router.Bind(robobus::types::MessageID::CreateMulticast(
+                      MulticastSessionID(5), DeviceID(2)),
+                  [&queues](robobus::router::DecodedID const &id,
+                            CanFrame const &frame) {
+                    MulticastSample<WheelSpeed> sample;
+                    std::memcpy(&sample.value, frame.data.data(),
+                                sizeof(WheelSpeed));
+                    sample.sender = id.sender;
+                    for (auto &queue : queues) {
+                      queue.push_back(sample);
+                    }
+                  });
+
+      copy = Measure([&](std::uint32_t i) {
+        bus->Inject(Frame(i));
+        for (auto &queue : queues) {
+          while (!queue.empty()) {
+            copy_checksum += queue.front().value.rpm[0];
+            queue.pop_front();
+          }
+        }
+      });
+    }
+
+    std::uint64_t session_checksum = 0;
+    Result shared;
+    {
+      auto bus = std::make_shared<InjectBus>();
+      auto router = std::make_shared<robobus::router::MessageRouter>(bus);
+      MulticastSession<WheelSpeed> session(router, MulticastSessionID(5),
+                                           DeviceID(2));
+      std::vector<MulticastSession<WheelSpeed>::Subscriber> readers;
+      for (std::size_t i = 0; i < subscribers; i++) {
+        readers.push_back(session.Subscribe());
+      }
+
+      shared = Measure([&](std::uint32_t i) {
+        bus->Inject(Frame(i));
+        for (auto &reader : readers) {
+          reader.Poll([&session_checksum](auto const &sample) {
+            session_checksum += sample.value.rpm[0];
+          });
+        }
+      });
+    }
+
+    fmt::print(
+        "multicast: subscribers={:2d} copy {:6.1f} ns/sample "
+        "(allocs/sample={:.2f})  shared {:6.1f} ns/sample "
+        "(allocs/sample={:.2f})  checksum={:d}/{:d}\n",
+        subscribers, copy.ns_per_sample, copy.allocs_per_sample,
+        shared.ns_per_sample, shared.allocs_per_sample, copy_checksum,
+        session_checksum);
+  }
+}
+}  // namespace bench::multicast
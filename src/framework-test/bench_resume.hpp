@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+
+#include <chrono>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <robobus/coroutine/coroutine.hpp>
+#include <robobus/runtime/loop.hpp>
+#include <robobus/runtime/sleep.hpp>
+
+namespace bench::resume {
+using robobus::coroutine::Coroutine;
+using robobus::runtime::Loop;
+
+/// @brief 長時間 Sleep し続けるだけのコルーチン (タイマーキューを埋める)
+template <typename Clock>
+Coroutine<void> Sleeper(Loop<Clock>& loop) {
+  using namespace std::chrono_literals;
+
+  while (true) {
+    co_await robobus::runtime::Sleep(loop, 1h);
+  }
+}
+
+/// @brief 0 秒 Sleep を繰り返して再開回数を数えるコルーチン
+template <typename Clock>
+Coroutine<void> Ticker(Loop<Clock>& loop, std::uint64_t& count,
+                       std::uint64_t limit) {
+  while (count < limit) {
+    count++;
+    co_await robobus::runtime::Sleep(loop, Clock::duration::zero());
+  }
+}
+
+/// @brief sleepers 個のコルーチンが Sleep している状態での再開スループットを計測
+template <typename Clock>
+void Measure(int sleepers, std::uint64_t resumes) {
+  Loop<Clock> loop;
+  loop.ReserveTimers(sleepers + 1);
+
+  std::vector<Coroutine<void>> sleeping;
+  sleeping.reserve(sleepers);
+  for (int i = 0; i < sleepers; i++) {
+    sleeping.push_back(Sleeper(loop));
+  }
+
+  std::uint64_t count = 0;
+  auto ticker = Ticker(loop, count, resumes);
+
+  auto begin = std::chrono::steady_clock::now();
+  while (count < resumes) {
+    loop.Poll();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+
+  // 終わらないコルーチンのフレームを (Loop が残っている間に) 破棄してプールに返す．
+  // Ticker は count が limit に達した直後の Sleep で止まっている
+  for (auto &sleeper : sleeping) {
+    sleeper.handle.destroy();
+  }
+  ticker.handle.destroy();
+
+  auto elapsed_s = std::chrono::duration<double>(elapsed).count();
+  fmt::print("resume: sleepers={:5d} resumes={:8d} {:8.3f} ms  {:12.0f} /s\n",
+             sleepers, resumes, elapsed_s * 1E3, resumes / elapsed_s);
+}
+
+template <typename Clock>
+void Run() {
+  for (int sleepers : {10, 100, 1000}) {
+    Measure<Clock>(sleepers, 200000);
+  }
+}
+}  // namespace bench::resume
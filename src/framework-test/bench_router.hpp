@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <robobus/can/can_bus.hpp>
+#include <robobus/router/message_router.hpp>
+
+namespace bench::router {
+using robobus::router::DecodedID;
+using robobus::router::MessageRouter;
+using robobus::types::CanFrame;
+using robobus::types::CanFrameFlags;
+using robobus::types::MessageID;
+
+constexpr std::uint32_t kFrames = 1000000;
+
+/// @brief 受信したフレームを rx に流すだけのバス
+class InjectBus : public robobus::can::CanBus {
+ public:
+  auto Send(CanFrame const &) -> bool override { return true; }
+
+  void Inject(CanFrame const &frame) { Deliver(frame); }
+};
+
+/// @brief P2P パイプの MessageID (marker は kServerData)
+auto PipeId(std::uint32_t pipe) -> MessageID {
+  return MessageID(2u << 16 | pipe << 2);
+}
+
+/// @brief 全てのパイプに順にフレームを流し，1 フレームあたりの時間を測る
+template <typename F>
+auto Measure(std::uint32_t pipes, F &&inject) -> double {
+  std::uint8_t payload[8] = {};
+  auto begin = std::chrono::steady_clock::now();
+  for (std::uint32_t i = 0; i < kFrames; i++) {
+    payload[0] = i & 0xFF;
+    inject(CanFrame::Create(PipeId(i % pipes).GetMsgID(), payload,
+                            CanFrameFlags::kExtended));
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+
+  return std::chrono::duration<double, std::nano>(elapsed).count() / kFrames;
+}
+
+/// @brief 受信者ごとに rx に繋いで ID を比べる方式と MessageRouter の振り分けを比べる
+void Run() {
+  for (std::uint32_t pipes : {1u, 4u, 16u, 32u}) {
+    std::uint64_t filter_checksum = 0;
+    double filter_ns;
+    {
+      // 以前の ControlStreamOnCAN と同じく，受信者がそれぞれ rx に繋がる
+      InjectBus bus;
+      std::vector<robobus::internal::SignalConnection<CanFrame>> connections;
+      for (std::uint32_t pipe = 0; pipe < pipes; pipe++) {
+        connections.push_back(bus.rx.Connect(
+            [id = PipeId(pipe).GetMsgID(),
+             &filter_checksum](CanFrame const &frame) {
+              if (frame.id == id) {
+                filter_checksum += frame.data[0];
+              }
+            }));
+      }
+
+      filter_ns = Measure(pipes, [&bus](CanFrame const &frame) {
+        bus.Inject(frame);
+      });
+    }
+
+    std::uint64_t router_checksum = 0;
+    double router_ns;
+    {
+      auto bus = std::make_shared<InjectBus>();
+      MessageRouter router(bus);
+      for (std::uint32_t pipe = 0; pipe < pipes; pipe++) {
+        router.Bind(PipeId(pipe),
+                    [&router_checksum](DecodedID const &,
+                                       CanFrame const &frame) {
+                      router_checksum += frame.data[0];
+                    });
+      }
+
+      router_ns = Measure(pipes, [&bus](CanFrame const &frame) {
+        bus->Inject(frame);
+      });
+    }
+
+    fmt::print(
+        "router: pipes={:2d} filter {:6.1f} ns/frame  router {:6.1f} ns/frame "
+        "(checksum={:d}/{:d})\n",
+        pipes, filter_ns, router_ns, filter_checksum, router_checksum);
+  }
+}
+}  // namespace bench::router
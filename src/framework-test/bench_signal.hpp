@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <internal/signal.hpp>
+
+#include "bench_alloc.hpp"
+
+namespace bench::signal {
+using CANDataType = std::vector<std::uint8_t>;
+
+constexpr std::uint32_t kFrames = 1000000;
+
+/// @brief 以前の Signal と同じく std::function<void(T)> の配列に値渡しで通知するもの
+template <typename T>
+class LegacySignal {
+  std::vector<std::function<void(T)>> slots_;
+
+ public:
+  void Connect(std::function<void(T const&)> slot) { slots_.push_back(slot); }
+
+  void Fire(T const& data) {
+    for (auto& slot : slots_) {
+      slot(data);
+    }
+  }
+};
+
+/// @brief robobus::internal::Signal を LegacySignal と同じ形で使うための薄いラッパ
+template <typename T>
+class InlineSignal {
+  robobus::internal::SignalTx<T> tx_{
+      std::make_shared<robobus::internal::Signal<T>>()};
+  robobus::internal::SignalRx<T> rx_{tx_};
+
+ public:
+  template <typename F>
+  void Connect(F&& slot) {
+    rx_.Connect(std::forward<F>(slot));
+  }
+
+  void Fire(T const& data) { tx_.Fire(data); }
+};
+
+/// @brief ControlStream の受信側 (FeedRxData から rx_data の通知まで) を模したもの
+/// @details 受信データの検証が通ると state_feedback の更新 (制御フレームの送信) と
+///  rx_data, is_ok の通知が起きる．rx_data には ControlStreamOnCAN と
+///  アプリケーションの 2 つの Slot が繋がっている
+template <template <typename> class Signal>
+class RxPath {
+  Signal<std::uint32_t> state_feedback_;
+  Signal<CANDataType> tx_ctrl_;
+  Signal<CANDataType> rx_data_;
+  Signal<int> is_ok_;
+
+  std::uint32_t state_ = 0;
+  CANDataType ctrl_ = CANDataType(8);
+
+ public:
+  std::uint64_t sent_bytes = 0;
+  std::uint64_t received = 0;
+  std::uint64_t checksum = 0;
+
+  RxPath() {
+    state_feedback_.Connect([this](std::uint32_t const& state) {
+      for (int i = 0; i < 4; i++) {
+        ctrl_[4 + i] = (state >> (24 - 8 * i)) & 0xFF;
+      }
+      tx_ctrl_.Fire(ctrl_);
+    });
+    tx_ctrl_.Connect(
+        [this](CANDataType const& data) { sent_bytes += data.size(); });
+
+    rx_data_.Connect([this](CANDataType const&) { received++; });
+    rx_data_.Connect([this](CANDataType const& data) {
+      checksum += (data[6] << 8) | data[7];
+    });
+    is_ok_.Connect([this](int) { received++; });
+  }
+
+  void FeedRxData(CANDataType const& data) {
+    state_ = (state_ * data[7] + data[7]) ^ (state_ >> 16);
+
+    state_feedback_.Fire(state_);
+    rx_data_.Fire(data);
+    is_ok_.Fire(0);
+  }
+};
+
+template <template <typename> class Signal>
+void Measure(const char* name) {
+  RxPath<Signal> path;
+  CANDataType frame(8);
+
+  auto allocations = alloc::Count();
+  auto begin = std::chrono::steady_clock::now();
+  for (std::uint32_t i = 0; i < kFrames; i++) {
+    frame[6] = (i >> 8) & 0xFF;
+    frame[7] = i & 0xFF;
+    path.FeedRxData(frame);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+  allocations = alloc::Count() - allocations;
+
+  auto elapsed_ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  fmt::print(
+      "signal: {:6s} frames={:d} {:6.1f} ns/frame  allocs/frame={:.2f} "
+      "(checksum={:d})\n",
+      name, kFrames, elapsed_ns / kFrames,
+      static_cast<double>(allocations) / kFrames, path.checksum);
+}
+
+/// @brief ControlStream の受信経路で，以前の Signal と新しい Signal を比べる
+void Run() {
+  Measure<LegacySignal>("legacy");
+  Measure<InlineSignal>("inline");
+}
+}  // namespace bench::signal
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <chrono>
+#include <optional>
+
+#include <fmt/format.h>
+
+#include <robobus/can/socket_can_bus.hpp>
+
+namespace bench::socket_can {
+using robobus::can::SocketCanBus;
+using robobus::types::CanFrame;
+
+/// @brief 計測に使うインターフェース (無ければ計測を飛ばす)
+/// @details `ip link add dev vcan0 type vcan && ip link set up vcan0` で作る
+constexpr char const *kInterface = "vcan0";
+constexpr std::uint32_t kFrames = 100000;
+
+struct Result {
+  double frames_per_s;
+  std::uint32_t received;
+  std::uint32_t out_of_order;
+  std::uint32_t tx_batches;
+  std::uint32_t rx_batches;
+};
+
+/// @brief tx から rx へ kFrames 個送り，届いた数と順序を確かめる
+/// @param flush_every この数だけ Send() するごとに Flush() する (1 で 1 フレームずつ)
+auto Measure(std::size_t flush_every) -> std::optional<Result> {
+  SocketCanBus tx;
+  SocketCanBus rx;
+  // vcan は loopback で同じホストの他のソケットに届ける
+  if (auto error = tx.Open(kInterface, {.loopback = true, .timestamps = false});
+      error != 0) {
+    fmt::print("socket_can: skipped ({}: {})\n", kInterface,
+               std::strerror(-error));
+    return std::nullopt;
+  }
+  if (auto error = rx.Open(kInterface); error != 0) {
+    fmt::print("socket_can: skipped ({}: {})\n", kInterface,
+               std::strerror(-error));
+    return std::nullopt;
+  }
+
+  Result result{};
+  std::uint32_t expected = 0;
+  rx.rx.Connect([&result, &expected](CanFrame const &frame) {
+    std::uint32_t value;
+    std::memcpy(&value, frame.data.data(), sizeof(value));
+    if (value != expected) {
+      result.out_of_order++;
+    }
+    expected = value + 1;
+    result.received++;
+  });
+
+  auto begin = std::chrono::steady_clock::now();
+  for (std::uint32_t i = 0; i < kFrames;) {
+    std::uint8_t payload[8] = {};
+    std::memcpy(payload, &i, sizeof(i));
+    if (tx.Send(CanFrame::Create(0x123, payload))) {
+      i++;
+      if (i % flush_every == 0) {
+        tx.Flush();
+      }
+      continue;
+    }
+
+    // カーネルの送信キュー (もしくは受信側) が一杯なので受け取って空ける
+    rx.Process(std::chrono::milliseconds(1));
+    tx.Flush();
+  }
+  while (tx.Pending() != 0) {
+    rx.Receive();
+    tx.Flush();
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (result.received < kFrames &&
+         std::chrono::steady_clock::now() < deadline) {
+    rx.Process(std::chrono::milliseconds(10));
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+
+  result.frames_per_s =
+      result.received / std::chrono::duration<double>(elapsed).count();
+  result.tx_batches = tx.Stats().tx_batches;
+  result.rx_batches = rx.Stats().rx_batches;
+  return result;
+}
+
+/// @brief 1 フレームずつ送る場合と sendmmsg() でまとめて送る場合を比べる
+void Run() {
+  for (std::size_t flush_every : {1u, 8u, 32u}) {
+    auto result = Measure(flush_every);
+    if (!result) {
+      return;
+    }
+
+    fmt::print(
+        "socket_can: flush every {:2d} {:9.0f} frames/s  received={:d}/{:d} "
+        "out_of_order={:d}  tx_batches={:d} rx_batches={:d}\n",
+        flush_every, result->frames_per_s, result->received, kFrames,
+        result->out_of_order, result->tx_batches, result->rx_batches);
+  }
+}
+}  // namespace bench::socket_can
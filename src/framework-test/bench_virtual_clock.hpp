@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+#include <chrono>
+
+#include <fmt/format.h>
+
+#include <robobus/coroutine/coroutine.hpp>
+#include <robobus/runtime/loop.hpp>
+#include <robobus/runtime/sleep.hpp>
+#include <robobus/runtime/virtual_clock.hpp>
+
+namespace bench::virtual_clock {
+using robobus::coroutine::Coroutine;
+using robobus::runtime::Loop;
+using robobus::runtime::VirtualClock;
+
+/// @brief 再開順序を記録するためのハッシュ (FNV-1a)
+struct Trace {
+  std::uint64_t hash = 0xcbf29ce484222325;
+  std::uint64_t resumes = 0;
+
+  void Record(int id, VirtualClock::time_point time) {
+    auto mix = [this](std::uint64_t value) {
+      hash = (hash ^ value) * 0x100000001b3;
+    };
+
+    mix(id);
+    mix(time.time_since_epoch().count());
+    resumes++;
+  }
+};
+
+Coroutine<void> Periodic(Loop<VirtualClock>& loop, Trace& trace, int id,
+                         VirtualClock::duration period) {
+  while (true) {
+    trace.Record(id, loop.time.Now());
+    co_await robobus::runtime::Sleep(loop, period);
+  }
+}
+
+auto Simulate(std::chrono::hours length) -> Trace {
+  using namespace std::chrono_literals;
+
+  VirtualClock::Reset();
+  Loop<VirtualClock> loop;
+  Trace trace;
+
+  Coroutine<void> tasks[] = {
+      Periodic(loop, trace, 0, 1ms),   Periodic(loop, trace, 1, 1ms),
+      Periodic(loop, trace, 2, 10ms),  Periodic(loop, trace, 3, 100ms),
+      Periodic(loop, trace, 4, 1s),
+  };
+
+  loop.RunFor(length);
+
+  // Sleep で止まっているフレームを Loop が残っている間に破棄する
+  for (auto &task : tasks) {
+    task.handle.destroy();
+  }
+
+  return trace;
+}
+
+/// @brief 仮想時計で長時間のシミュレーションを行い，速度と再現性を確認する
+void Run() {
+  using namespace std::chrono_literals;
+  const auto length = 1h;
+
+  auto begin = std::chrono::steady_clock::now();
+  auto first = Simulate(length);
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+  auto second = Simulate(length);
+
+  auto elapsed_s = std::chrono::duration<double>(elapsed).count();
+  auto simulated_s = std::chrono::duration<double>(length).count();
+  fmt::print(
+      "virtual_clock: simulated {:.0f} s in {:8.3f} ms (x{:.0f}), "
+      "resumes={:d}, deterministic={}\n",
+      simulated_s, elapsed_s * 1E3, simulated_s / elapsed_s, first.resumes,
+      first.hash == second.hash && first.resumes == second.resumes);
+}
+}  // namespace bench::virtual_clock
@@ -8,6 +8,7 @@
 
 #include <robobus/context/context.hpp>
 #include <robobus/coroutine/coroutine.hpp>
+#include <robobus/debug/debug_channel.hpp>
 
 #include "test_clock.hpp"
 #include "measurement.hpp"
@@ -27,11 +28,13 @@ class SimpleLogSink : public robotics::logger::LogSink {
   }
 };
 
-class SimpleDebugAdapter : public robobus::debug::DebugAdapter {
+/// @brief DebugChannel のバッチを `$1$bin$<len><bytes>$` として標準出力へ書き出す
+class StdoutDebugTransport : public robobus::debug::DebugTransport {
  public:
-  void Message(std::string_view path, std::string_view text) override {
-    std::cout << fmt::format("$1$dbg${:d}{:s}${:d}{:s}$\n", path.size(), path,
-                             text.size(), text);
+  void Write(std::uint8_t const* data, std::size_t size) override {
+    std::cout << fmt::format("$1$bin${:d}", size);
+    std::cout.write(reinterpret_cast<char const*>(data), size);
+    std::cout << "$\n" << std::flush;
   }
 };
 
@@ -42,7 +45,7 @@ Coroutine<void> Task(SharedContext<Clock> ctx,
 
   logger.RenameTag("   Test  ");
 
-  logger.Info("Started 'Task' (cid = %s)", ctx.ContextId().c_str());
+  logger.Info("Started 'Task' (cid = %s)", ctx.Path());
 
   co_await ctx.Sleep(delay);
 
@@ -52,6 +55,7 @@ Coroutine<void> Task(SharedContext<Clock> ctx,
         std::chrono::duration_cast<std::chrono::seconds>(now).count();
 
     test_debug.Message(fmt::format("Time: {}", now_s));
+    test_debug.Int(static_cast<std::int32_t>(now_s));
 
     co_await ctx.Sleep(1s);
   }
@@ -77,7 +81,10 @@ int main() {
 
   auto ctx = SharedRootContext<Clock>();
   // ctx.GetLoop().LaunchDebugThread();
-  ctx.SetDebugAdapter(std::make_shared<SimpleDebugAdapter>());
+  auto debug_channel = std::make_shared<robobus::debug::DebugChannel<Clock>>(
+      std::make_unique<StdoutDebugTransport>());
+  debug_channel->StartFlusher(100ms);
+  ctx.SetDebugAdapter(debug_channel);
 
   LaunchLoopTask(ctx.Child("Loop"));
 
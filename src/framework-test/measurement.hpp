@@ -2,6 +2,8 @@
 
 #include <robobus/context/context.hpp>
 #include <robobus/coroutine/coroutine.hpp>
+#include <robobus/debug/profile_report.hpp>
+#include <robobus/debug/ticker_report.hpp>
 
 #include <chrono>
 
@@ -14,26 +16,31 @@ class Measurement {
     float tps;
     float avg_tps;
     int delta_ticks;
+    robobus::runtime::TickerStats<Clock> ticker;
   };
 
  public:
   Measurement(SharedContext<Clock> ctx) : ctx_(ctx) {
-    ctx.AddTask(Measure().handle);
+    ctx.Start(robobus::runtime::Priority::kDiagnostics,
+              [this] { return Measure(); });
     ctx.AddTask(Countup().handle);
   }
 
   Coroutine<void> Countup() {
     using namespace std::chrono_literals;
 
+    auto tick = ctx_.Every(1ms);
     while (true) {
+      co_await tick;
       data_->delta_ticks += 1;
-      co_await ctx_.Sleep(1ms);
+      data_->ticker = tick.Stats();
     }
   }
 
   Coroutine<void> Measure() {
     using namespace std::chrono_literals;
     auto logger = ctx_.Logger();
+    auto ticker_debug = ctx_.GetDebugInfo("ticker");
 
     auto begin_time = ctx_.GetLoop().time.Now();
 
@@ -47,6 +54,14 @@ class Measurement {
       data_->delta_ticks = 0;
 
       logger.Info("TPS: %f, avg TPS: %f", data_->tps, data_->avg_tps);
+      robobus::debug::ReportTicker(ticker_debug, data_->ticker);
+
+#if ROBOBUS_ENABLE_PROFILING
+      auto& root = ctx_.Root();
+      if (auto adapter = root.GetDebugAdapter()) {
+        robobus::debug::ReportProfiles(root, **adapter);
+      }
+#endif
 
       co_await ctx_.Sleep(1000ms);
     }
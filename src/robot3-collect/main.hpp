@@ -5,6 +5,11 @@
 #include <robotics/network/fep/fep_driver.hpp>
 #include <robotics/network/uart_stream.hpp>
 
+#include <robobus/coroutine/coroutine.hpp>
+#include <robobus/runtime/isr_queue.hpp>
+#include <robobus/runtime/loop.hpp>
+#include <robobus/runtime/ticker.hpp>
+
 #include "app.hpp"
 #include "collect.hpp"
 
@@ -14,6 +19,7 @@ template <typename T>
 using Node = robotics::node::Node<T>;
 
 using robotics::types::JoyStick2D;
+using robobus::coroutine::Coroutine;
 
 class PuropoController {
   Puropo puropo;
@@ -49,8 +55,13 @@ class PuropoController {
 
 class Test {
   using Actuators = nhk2024b::robot3::Actuators;
+  using Clock = rtos::Kernel::Clock;
+
+  robobus::runtime::Loop<Clock> loop;
 
   InterruptIn hard_emc_gpio{PA_15, PinMode::PullDown};
+  /// hard_emc_gpio の変化 (割り込みから積み，WatchHardEMC() が Loop 上で処理する)
+  robobus::runtime::IsrQueue<Clock, bool, 8> hard_emc_events{loop};
 
   Actuators actuators{(Actuators::Config){
       .move_motor_fin = PB_10,
@@ -76,6 +87,48 @@ class Test {
     robot.emc_state.SetValue(emc_out);
   }
 
+  Coroutine<void> WatchHardEMC() {
+    while (true) {
+      co_await hard_emc_events.Next();
+      // 積み切れずに捨てた変化があっても最後の状態に揃うようピンを読み直す
+      hard_emc = hard_emc_gpio.read();
+      UpdateEMC();
+    }
+  }
+
+  Coroutine<void> Update() {
+    using namespace std::chrono_literals;
+
+    auto tick = robobus::runtime::Every(loop, 1ms);
+
+    int i = 0;
+    while (true) {
+      co_await tick;
+
+      if (i % 1000 == 0)
+        logger.Info("Update");
+      puropo.Tick();
+
+      if (i % 200 == 0) {
+        logger.Info("Report");
+        logger.Info("  Stick: %f, %f; %f, %f",    //
+                    puropo.stick1.GetValue()[0],  //
+                    puropo.stick1.GetValue()[1],  //
+                    puropo.stick2.GetValue()[0],  //
+                    puropo.stick2.GetValue()[1]   //
+        );
+        logger.Info("  output: %f %f %f",                      //
+                    actuators.move_motor.GetValue(),           //
+                    actuators.arm_elevation_motor.GetValue(),  //
+                    actuators.arm_expansion_motor.GetValue()   //
+        );
+        logger.Info("  (emc_ctrl = %d) & (hard_emc = %d) -> (emc_out = %d)",
+                    ctrl_emc, hard_emc, ctrl_emc & hard_emc);
+      }
+      i += 1;
+    }
+  }
+
  public:
   void Init() {
     logger.Info("Init");
@@ -97,52 +150,22 @@ class Test {
 
     puropo.button5.SetValue(false);
 
-    hard_emc_gpio.fall([this]() {
-      this->hard_emc = false;
-      this->UpdateEMC();
-    });
-    hard_emc_gpio.rise([this]() {
-      this->hard_emc = true;
-      this->UpdateEMC();
-    });
+    // 割り込みでは Node を更新せず，Loop 上のコルーチンに渡す
+    hard_emc_gpio.fall([this]() { hard_emc_events.Post(false); });
+    hard_emc_gpio.rise([this]() { hard_emc_events.Post(true); });
     this->hard_emc = hard_emc_gpio.read();
     this->UpdateEMC();
 
     logger.Info("Init done");
   }
 
+  [[noreturn]]
   void Main() {
     logger.Info("Main loop");
 
-    Timer timer;
-    timer.reset();
-    timer.start();
-
-    int i = 0;
-    while (true) {
-      if (i % 1000 == 0)
-        logger.Info("Update");
-      puropo.Tick();
-
-      if (i % 200 == 0) {
-        logger.Info("Report");
-        logger.Info("  Stick: %f, %f; %f, %f",    //
-                    puropo.stick1.GetValue()[0],  //
-                    puropo.stick1.GetValue()[1],  //
-                    puropo.stick2.GetValue()[0],  //
-                    puropo.stick2.GetValue()[1]   //
-        );
-        logger.Info("  output: %f %f %f",                      //
-                    actuators.move_motor.GetValue(),           //
-                    actuators.arm_elevation_motor.GetValue(),  //
-                    actuators.arm_expansion_motor.GetValue()   //
-        );
-        logger.Info("  (emc_ctrl = %d) & (hard_emc = %d) -> (emc_out = %d)",
-                    ctrl_emc, hard_emc, ctrl_emc & hard_emc);
-      }
-      i += 1;
-      ThisThread::sleep_for(1ms);
-    }
+    loop.AddTask(WatchHardEMC().handle);
+    loop.AddTask(Update().handle);
+    loop.Run();
   }
 };
 